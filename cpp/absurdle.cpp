@@ -0,0 +1,239 @@
+#include "utils.h"
+#include "shared_table.h"
+#include "task_scheduler.h"
+
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// adversarial (absurdle style) wordle: the host has no fixed answer and after every guess keeps
+// the largest partition of the words still possible. the game is won once only one word is
+// left and it gets guessed.
+//
+//   --host: you guess, the host answers adversarially.
+//   otherwise: search for the fewest guesses that beat the host, or with --worst-case, that win
+//   whichever partition any adversary keeps (true minimax).
+
+struct AdversarySearch {
+  const std::vector<std::string>& guess_list;
+  const uint8_t* patterns;
+  int num_sols;
+  // true: every partition has to be winnable; false: only the one absurdle keeps.
+  bool worst_case;
+  int shortlist_size;
+
+  // candidate set -> most guesses left we already know are not enough.
+  std::mutex memo_mutex;
+  std::unordered_map<std::string, int> fails_with;
+
+  const uint8_t* row(int guess) const {
+    return patterns + (size_t)guess * num_sols;
+  }
+
+  static std::string key(const std::vector<int>& sols) {
+    return std::string((const char*)sols.data(), sols.size() * sizeof(int));
+  }
+
+  // guesses worth trying for sols: the shortlist_size with the smallest largest bucket. a
+  // guess that leaves everything in one non-green bucket makes no progress and is skipped.
+  std::vector<std::pair<int, int>> shortlist(const std::vector<int>& sols) const {
+    std::vector<std::pair<int, int>> scored;
+    for (int g = 0; g < guess_list.size(); ++g) {
+      auto [pattern, size] = max_bucket_from_patterns(row(g), sols);
+      if (size == sols.size() && pattern != 0) {
+	continue;
+      }
+      scored.push_back(std::make_pair(size, g));
+    }
+    int n = std::min<int>(shortlist_size, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + n, scored.end());
+    scored.resize(n);
+    return scored;
+  }
+
+  // can we always win within guesses_left guesses from here? fills line with our guesses.
+  bool can_win(const std::vector<int>& sols, int guesses_left, std::vector<int>& line) {
+    if (sols.size() == 1) {
+      return guesses_left >= 1;
+    }
+    // one guess per turn splits into at most 243 partitions, and the last guess has to be the word.
+    long long max_solvable = 1;
+    for (int i = 1; i < guesses_left && max_solvable < sols.size(); ++i) {
+      max_solvable *= 243;
+    }
+    if (guesses_left <= 1 || sols.size() > max_solvable) {
+      return false;
+    }
+    std::string k = key(sols);
+    {
+      std::lock_guard<std::mutex> lock(memo_mutex);
+      auto it = fails_with.find(k);
+      if (it != fails_with.end() && guesses_left <= it->second) {
+	return false;
+      }
+    }
+    for (const auto& [largest, g] : shortlist(sols)) {
+      if (!worst_case && largest == 1 && guesses_left >= 2) {
+	// every word is in its own partition: the next guess wins (or this one did).
+	line.push_back(g);
+	return true;
+      }
+      line.push_back(g);
+      if (wins_with_guess(sols, g, guesses_left, line)) {
+	return true;
+      }
+      line.pop_back();
+    }
+    std::lock_guard<std::mutex> lock(memo_mutex);
+    fails_with[k] = std::max(fails_with[k], guesses_left);
+    return false;
+  }
+
+  bool wins_with_guess(const std::vector<int>& sols, int g, int guesses_left, std::vector<int>& line) {
+    if (!worst_case) {
+      // absurdle keeps the largest partition; that's the only reply we have to beat.
+      int pattern = max_bucket_from_patterns(row(g), sols).first;
+      if (pattern == 0) {
+	return true;
+      }
+      std::vector<int> kept;
+      for (int s : sols) {
+	if (row(g)[s] == pattern) {
+	  kept.push_back(s);
+	}
+      }
+      return can_win(kept, guesses_left - 1, line);
+    }
+    std::vector<std::vector<int>> partitions = partition_by_row(g, sols);
+    for (int p = 1; p < 243; ++p) {
+      std::vector<int> sub_line;
+      if (!partitions[p].empty() && !can_win(partitions[p], guesses_left - 1, sub_line)) {
+	return false;
+      }
+    }
+    return true;
+  }
+
+  std::vector<std::vector<int>> partition_by_row(int g, const std::vector<int>& sols) const {
+    std::vector<std::vector<int>> partitions(243);
+    for (int s : sols) {
+      partitions[row(g)[s]].push_back(s);
+    }
+    return partitions;
+  }
+};
+
+int main(int argc, char** argv) {
+  // usage: ./absurdle --host
+  //        ./absurdle [--worst-case] [--max-guesses N] [--shortlist N] [--threads N] [--table-dir DIR] [--word-files]
+  bool host = false;
+  bool worst_case = false;
+  int max_guesses = 6;
+  int shortlist_size = 30;
+  int num_threads = 0;
+  std::string table_dir;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--host") {
+      host = true;
+    } else if (arg == "--worst-case") {
+      worst_case = true;
+    } else if (arg == "--word-files") {
+      use_word_files();
+    } else if (arg == "--max-guesses" && i + 1 < argc) {
+      max_guesses = std::stoi(argv[++i]);
+    } else if (arg == "--shortlist" && i + 1 < argc) {
+      shortlist_size = std::stoi(argv[++i]);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      num_threads = std::stoi(argv[++i]);
+    } else if (arg == "--table-dir" && i + 1 < argc) {
+      table_dir = argv[++i];
+    }
+  }
+
+  std::vector<std::string> guess_list = load_guess_words();
+  std::vector<std::string> solution_list = load_sol_words();
+  PatternTable patterns = table_dir.empty() ? PatternTable::build(guess_list, solution_list) : PatternTable::open_shared(table_dir, guess_list, solution_list);
+  std::vector<int> sols(solution_list.size());
+  std::iota(std::begin(sols), std::end(sols), 0);
+
+  if (host) {
+    std::string guess;
+    int turn = 0;
+    while (std::cout << "guess:" << std::endl && std::cin >> guess) {
+      auto it = std::find(guess_list.begin(), guess_list.end(), guess);
+      if (it == guess_list.end()) {
+	std::cout << guess << " is not a valid guess" << std::endl;
+	continue;
+      }
+      turn++;
+      const uint8_t* row = patterns.data() + (size_t)(it - guess_list.begin()) * solution_list.size();
+      int pattern = max_bucket_from_patterns(row, sols).first;
+      std::vector<int> kept;
+      for (int s : sols) {
+	if (row[s] == pattern) {
+	  kept.push_back(s);
+	}
+      }
+      sols = kept;
+      std::cout << pattern_to_string(pattern) << ", " << sols.size() << " words left" << std::endl;
+      if (pattern == 0) {
+	std::cout << "you won in " << turn << " guesses" << std::endl;
+	return 0;
+      }
+    }
+    return 0;
+  }
+
+  // iterative deepening; the first guess's subtrees are searched in parallel.
+  AdversarySearch search{guess_list, patterns.data(), (int)solution_list.size(), worst_case, shortlist_size};
+  std::vector<std::pair<int, int>> openers = search.shortlist(sols);
+  for (int guesses = 2; guesses <= max_guesses; ++guesses) {
+    std::cout << "trying to win within " << guesses << " guesses" << std::endl;
+    std::mutex best_mutex;
+    int best_opener = -1;
+    std::vector<int> best_line;
+    {
+      TaskScheduler scheduler(num_threads);
+      for (int i = 0; i < openers.size(); ++i) {
+	scheduler.spawn([&, i]() {
+	  std::vector<int> line = {openers.at(i).second};
+	  if (search.wins_with_guess(sols, openers.at(i).second, guesses, line)) {
+	    std::lock_guard<std::mutex> lock(best_mutex);
+	    // lowest shortlist position wins, so the answer doesn't depend on scheduling.
+	    if (best_opener < 0 || i < best_opener) {
+	      best_opener = i;
+	      best_line = line;
+	    }
+	  }
+	});
+      }
+    }
+    if (best_opener >= 0) {
+      std::cout << "can win within " << guesses << " guesses" << (worst_case ? " against any adversary" : "") << ", line:";
+      // replay the line against the host to show what it leaves for the last guess.
+      std::vector<int> left = sols;
+      for (int g : best_line) {
+	std::cout << " " << guess_list.at(g);
+	int pattern = max_bucket_from_patterns(search.row(g), left).first;
+	std::vector<int> kept;
+	for (int s : left) {
+	  if (search.row(g)[s] == pattern) {
+	    kept.push_back(s);
+	  }
+	}
+	left = kept;
+      }
+      if (!worst_case && left.size() == 1 && solution_list.at(left.at(0)) != guess_list.at(best_line.back())) {
+	std::cout << " " << solution_list.at(left.at(0));
+      }
+      std::cout << std::endl;
+      return 0;
+    }
+  }
+  std::cout << "no win within " << max_guesses << " guesses among the shortlisted guesses" << std::endl;
+  return 1;
+}
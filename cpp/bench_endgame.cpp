@@ -0,0 +1,137 @@
+#include "utils.h"
+#include "endgame.h"
+#include "prefilter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// times EndgameSolver on the small candidate sets a real game reaches: the partitions of the
+// opener and of the entropy guess after it. per size it prints how long the solver takes next to
+// the entropy search it replaces (get_best_word_prefiltered), which is what kEndgameThreshold is
+// picked from, and it fails if any set of 20 to 30 words takes longer than --max-ms. sets of up
+// to --exact-max words are also solved with no shortlist, which is exact, to show what the
+// shortlist above kEndgameExactSize words gives up.
+
+template <typename F>
+double time_ms(F&& f) {
+  auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+std::vector<std::vector<int>> partitions_of(const std::string& guess, const std::vector<std::string>& sol_words, const std::vector<int>& sol_idxs) {
+  std::vector<std::vector<int>> partitions(243);
+  for (int s : sol_idxs) {
+    partitions[calc_pattern(guess, sol_words.at(s))].push_back(s);
+  }
+  partitions.erase(partitions.begin());
+  return partitions;
+}
+
+// total guesses to solve every word in sols by always taking the best entropy guess.
+int entropy_total(const std::vector<std::string>& guess_words, const std::vector<int>& guess_idxs, const std::vector<std::string>& sol_words, const std::vector<int>& sols) {
+  if (sols.size() <= 1) {
+    return sols.size();
+  }
+  std::string guess = get_best_word_prefiltered(guess_words, guess_idxs, sol_words, sols, kPrefilterShortlist, /*exact=*/true).first;
+  int total = sols.size();
+  for (const auto& partition : partitions_of(guess, sol_words, sols)) {
+    total += entropy_total(guess_words, guess_idxs, sol_words, partition);
+  }
+  return total;
+}
+
+int main(int argc, char** argv) {
+  // usage: ./bench_endgame [--opener WORD] [--max-size N] [--max-ms MS] [--exact-max N] [--word-files]
+  std::string opener = "soare";
+  int max_size = 32;
+  double max_ms = 50.0;
+  int exact_max = 16;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--opener" && i + 1 < argc) {
+      opener = argv[++i];
+    } else if (arg == "--max-size" && i + 1 < argc) {
+      max_size = std::min(32, std::stoi(argv[++i]));
+    } else if (arg == "--max-ms" && i + 1 < argc) {
+      max_ms = std::stod(argv[++i]);
+    } else if (arg == "--exact-max" && i + 1 < argc) {
+      exact_max = std::stoi(argv[++i]);
+    } else if (arg == "--word-files") {
+      use_word_files();
+    }
+  }
+
+  std::vector<std::string> guess_words = load_guess_words();
+  std::vector<std::string> sol_words = load_sol_words();
+  std::vector<int> all_guess_idxs(guess_words.size());
+  std::iota(std::begin(all_guess_idxs), std::end(all_guess_idxs), 0);
+  std::vector<int> all_sol_idxs(sol_words.size());
+  std::iota(std::begin(all_sol_idxs), std::end(all_sol_idxs), 0);
+
+  // every set of 2..max_size words at depth one and two.
+  std::vector<std::vector<int>> sets;
+  for (const auto& partition : partitions_of(opener, sol_words, all_sol_idxs)) {
+    if (partition.size() > max_size) {
+      std::string guess = get_best_word_prefiltered(guess_words, all_guess_idxs, sol_words, partition, kPrefilterShortlist, /*exact=*/true).first;
+      for (const auto& child : partitions_of(guess, sol_words, partition)) {
+	if (child.size() >= 2 && child.size() <= max_size) {
+	  sets.push_back(child);
+	}
+      }
+    } else if (partition.size() >= 2) {
+      sets.push_back(partition);
+    }
+  }
+
+  struct Stats {
+    int count = 0;
+    double endgame_ms = 0.0;
+    double endgame_max_ms = 0.0;
+    double entropy_ms = 0.0;
+    double expected = 0.0;
+    double entropy_expected = 0.0;
+    double exact_expected = 0.0;
+  };
+  std::map<int, Stats> by_size;
+  double worst_ms = 0.0;
+  for (const auto& sols : sets) {
+    std::pair<int, double> best;
+    double ms = time_ms([&]() {
+      EndgameSolver solver(guess_words, all_guess_idxs, sol_words, sols);
+      best = solver.best_guess();
+    });
+    Stats& stats = by_size[sols.size()];
+    ++stats.count;
+    stats.endgame_ms += ms;
+    stats.endgame_max_ms = std::max(stats.endgame_max_ms, ms);
+    stats.entropy_ms += time_ms([&]() { get_best_word_prefiltered(guess_words, all_guess_idxs, sol_words, sols, kPrefilterShortlist, /*exact=*/true); });
+    stats.expected += best.second;
+    stats.entropy_expected += (double)entropy_total(guess_words, all_guess_idxs, sol_words, sols) / sols.size();
+    if (sols.size() <= exact_max) {
+      EndgameSolver exact(guess_words, all_guess_idxs, sol_words, sols, /*limits=*/nullptr, /*shortlist=*/0);
+      stats.exact_expected += exact.best_guess().second;
+    }
+    if (sols.size() >= 20 && sols.size() <= 30) {
+      worst_ms = std::max(worst_ms, ms);
+    }
+  }
+
+  std::cout << "size  sets  endgame avg/max ms  entropy avg ms  expected guesses endgame/entropy/exact" << std::endl;
+  for (const auto& [size, stats] : by_size) {
+    std::cout << size << "  " << stats.count << "  " << stats.endgame_ms / stats.count << "/" << stats.endgame_max_ms << "  "
+	      << stats.entropy_ms / stats.count << "  " << stats.expected / stats.count << "/" << stats.entropy_expected / stats.count << "/";
+    if (size <= exact_max) {
+      std::cout << stats.exact_expected / stats.count << std::endl;
+    } else {
+      std::cout << "-" << std::endl;
+    }
+  }
+  std::cout << "slowest set of 20 to 30 words: " << worst_ms << " ms (limit " << max_ms << " ms)" << std::endl;
+  return worst_ms > max_ms ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+#include "utils.h"
+#include "scoring.h"
+#include "tiled_sweep.h"
+
+#include <chrono>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+// times a full best-guess sweep (every guess against a candidate set) three ways: one row at a
+// time (best_guess_from_patterns), tiled guess-major and tiled solution-major, and reports the
+// memory bandwidth each achieves next to the machine's streaming read bandwidth.
+
+template <typename F>
+double time_ms(int reps, F&& f) {
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < reps; ++i) {
+    f();
+  }
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / reps;
+}
+
+// read bandwidth in GB/s, summing a buffer much larger than the last level cache.
+double peak_read_bandwidth() {
+  std::vector<uint64_t> buffer((256 << 20) / sizeof(uint64_t), 1);
+  volatile uint64_t sink = 0;
+  double ms = time_ms(3, [&]() {
+    uint64_t sum = 0;
+    for (uint64_t v : buffer) {
+      sum += v;
+    }
+    sink = sink + sum;
+  });
+  return buffer.size() * sizeof(uint64_t) / ms / 1e6;
+}
+
+int main(int argc, char** argv) {
+  // usage: ./bench_sweep [--reps N] [--tile-guesses N] [--tile-sols N] [--word-files]
+  int reps = 3;
+  TileSize tile;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--reps" && i + 1 < argc) {
+      reps = std::stoi(argv[++i]);
+    } else if (arg == "--tile-guesses" && i + 1 < argc) {
+      tile.guesses = std::stoi(argv[++i]);
+    } else if (arg == "--tile-sols" && i + 1 < argc) {
+      tile.sols = std::stoi(argv[++i]);
+    } else if (arg == "--word-files") {
+      use_word_files();
+    }
+  }
+
+  std::vector<std::string> guess_list = load_guess_words();
+  std::vector<std::string> solution_list = load_sol_words();
+  std::vector<uint8_t> patterns = build_pattern_table(guess_list, solution_list);
+  TiledPatternTable<5> table(patterns, guess_list.size(), solution_list.size(), /*with_solution_major=*/true);
+
+  std::vector<int> all_guess_idxs(guess_list.size());
+  std::iota(std::begin(all_guess_idxs), std::end(all_guess_idxs), 0);
+  std::vector<int> all_sol_idxs(solution_list.size());
+  std::iota(std::begin(all_sol_idxs), std::end(all_sol_idxs), 0);
+  // mid-game sized candidate sets: a random 1 in 10 and 1 in 100 of the solutions.
+  std::mt19937 rng(42);
+  std::vector<std::pair<std::string, std::vector<int>>> candidate_sets = {{"all solutions", all_sol_idxs}};
+  for (int every : {10, 100}) {
+    std::vector<int> sols;
+    for (int s : all_sol_idxs) {
+      if (rng() % every == 0) {
+	sols.push_back(s);
+      }
+    }
+    candidate_sets.push_back(std::make_pair("1 in " + std::to_string(every) + " solutions", sols));
+  }
+
+  double peak = peak_read_bandwidth();
+  std::cout << "streaming read bandwidth: " << peak << " GB/s" << std::endl;
+  std::cout << "tiles of " << tile.guesses << " guesses x " << tile.sols << " solutions" << std::endl;
+
+  for (const auto& [name, sols] : candidate_sets) {
+    std::cout << name << " (" << sols.size() << "):" << std::endl;
+    auto expected = best_guess_from_patterns<EntropyPolicy>(patterns, solution_list.size(), all_guess_idxs, sols);
+    auto report = [&](const std::string& method, double ms, size_t bytes) {
+      double gbps = bytes / ms / 1e6;
+      std::cout << "  " << method << ": " << ms << " ms, " << gbps << " GB/s (" << 100.0 * gbps / peak << "% of peak)" << std::endl;
+    };
+    double ms = time_ms(reps, [&]() { best_guess_from_patterns<EntropyPolicy>(patterns, solution_list.size(), all_guess_idxs, sols); });
+    // best_guess_tiled_n goes a row at a time wherever guess-major reads less.
+    bool row_chosen = table.choose_layout(all_guess_idxs.size(), sols.size()) == PatternLayout::kGuessMajor;
+    report(std::string("row at a time") + (row_chosen ? " [chosen]" : ""), ms, table.bytes_read(PatternLayout::kGuessMajor, all_guess_idxs.size(), sols.size()));
+    for (auto layout : {PatternLayout::kGuessMajor, PatternLayout::kSolutionMajor}) {
+      std::pair<int, double> best(-1, 0.0);
+      ms = time_ms(reps, [&]() {
+	best = std::make_pair(-1, 0.0);
+	for_each_histogram_tiled(table, layout, all_guess_idxs, sols, [&](int g, const int* counts) {
+	  double ent = EntropyPolicy::score(counts, sols.size());
+	  if (best.first < 0 || ent > best.second) {
+	    best = std::make_pair(g, ent);
+	  }
+	}, tile);
+      });
+      bool chosen = layout == PatternLayout::kSolutionMajor && !row_chosen;
+      report(std::string(layout == PatternLayout::kGuessMajor ? "tiled guess-major" : "tiled solution-major") + (chosen ? " [chosen]" : ""), ms, table.bytes_read(layout, all_guess_idxs.size(), sols.size()));
+      if (best != expected) {
+	std::cout << "  MISMATCH: " << guess_list.at(best.first) << " vs " << guess_list.at(expected.first) << std::endl;
+	return 1;
+      }
+    }
+  }
+}
@@ -0,0 +1,159 @@
+#include "utils.h"
+#include "dictionary.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// packs word lists into the binary dictionary the tools load at startup (see dictionary.h),
+// then checks it against the text files and times loading the 5-letter lists both ways.
+// --header writes them, and the opener scores in wordle.checkpoint, as a header to compile in
+// instead.
+
+// adjacent string literals of words_per_line words each.
+void write_packed_literal(std::ofstream& out, const std::vector<std::string>& words, int words_per_line) {
+  for (int i = 0; i < words.size(); i += words_per_line) {
+    out << "  \"";
+    for (int j = i; j < std::min<int>(words.size(), i + words_per_line); ++j) {
+      out << words[j];
+    }
+    out << "\"\n";
+  }
+}
+
+bool write_embedded_header(const std::string& path, const std::vector<std::string>& sources) {
+  std::ofstream out(path);
+  out << "// generated by build_dict --header from";
+  for (const auto& source : sources) {
+    out << " " << source;
+  }
+  out << " and wordle.checkpoint. don't edit.\n#pragma once\n\n#include \"dictionary.h\"\n\n";
+  std::vector<std::string> entries;
+  for (const auto& source : sources) {
+    std::ifstream in(source);
+    if (!in.good()) {
+      return false;
+    }
+    std::vector<std::vector<std::string>> words = load_words_by_length(source);
+    for (int len = 1; len <= kMaxWordLength; ++len) {
+      if (words[len].empty()) {
+	continue;
+      }
+      const std::string name = "kEmbeddedWords" + std::to_string(entries.size());
+      out << "constexpr char " << name << "[] =\n";
+      write_packed_literal(out, words[len], 100 / len);
+      out << "  ;\n\n";
+      entries.push_back("{\"" + source + "\", " + std::to_string(len) + ", " + std::to_string(words[len].size()) + ", " + name + "}");
+    }
+  }
+  out << "constexpr EmbeddedWordList kEmbeddedWordLists[] = {\n";
+  for (const auto& entry : entries) {
+    out << "  " << entry << ",\n";
+  }
+  out << "};\n\n";
+
+  // the scores as they're written in the checkpoint, so they parse to the same doubles.
+  std::vector<std::string> score_words;
+  std::vector<std::string> scores;
+  std::ifstream checkpoint("wordle.checkpoint");
+  std::string line;
+  while (std::getline(checkpoint, line)) {
+    int comma_pos = line.find(',');
+    if (comma_pos != 5) {
+      return false;
+    }
+    score_words.push_back(line.substr(0, comma_pos));
+    scores.push_back(line.substr(comma_pos + 1));
+  }
+  out << "constexpr int kNumEmbeddedScores = " << scores.size() << ";\n";
+  out << "constexpr char kEmbeddedScoreWords[] =\n";
+  write_packed_literal(out, score_words, 20);
+  out << "  ;\n\nconstexpr double kEmbeddedScores[] = {\n";
+  for (int i = 0; i < scores.size(); i += 10) {
+    out << " ";
+    for (int j = i; j < std::min<int>(scores.size(), i + 10); ++j) {
+      out << " " << scores[j] << ",";
+    }
+    out << "\n";
+  }
+  out << "};\n";
+  out.close();
+  return out.good();
+}
+
+int main(int argc, char** argv) {
+  // usage: ./build_dict [--out FILE] [--verify] [--header FILE] [word list files...]
+  // defaults to packing sowpods.txt and solutions.txt into words.dict. --verify only checks an
+  // existing dictionary, --header only writes the header.
+  std::string out = kDictionaryFile;
+  std::string header_path;
+  bool verify_only = false;
+  std::vector<std::string> sources;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--out" && i + 1 < argc) {
+      out = argv[++i];
+    } else if (arg == "--verify") {
+      verify_only = true;
+    } else if (arg == "--header" && i + 1 < argc) {
+      header_path = argv[++i];
+    } else {
+      sources.push_back(arg);
+    }
+  }
+  if (sources.empty()) {
+    sources = {"sowpods.txt", "solutions.txt"};
+  }
+  if (!header_path.empty()) {
+    if (!write_embedded_header(header_path, sources)) {
+      std::cout << "can't write " << header_path << " from the word lists and wordle.checkpoint" << std::endl;
+      return 1;
+    }
+    std::cout << "wrote " << header_path << "; build with -DWORDLE_EMBEDDED to compile it in" << std::endl;
+    return 0;
+  }
+
+  if (!verify_only && !write_dictionary(out, sources)) {
+    std::cout << "can't pack the word lists into " << out << std::endl;
+    return 1;
+  }
+  auto dictionary = PackedDictionary::open(out);
+  if (!dictionary || !dictionary->verify()) {
+    std::cout << out << " is missing or corrupt" << std::endl;
+    return 1;
+  }
+  std::cout << out << ": " << dictionary->header().file_size << " bytes" << std::endl;
+  for (int i = 0; i < dictionary->header().num_sections; ++i) {
+    const DictionarySection& section = dictionary->section(i);
+    PackedWordList list = dictionary->list(i);
+    // every word has to come back from the text file at its index, and be found by the index.
+    std::vector<std::string> text_words = load_words_by_length(section.source).at(section.word_length);
+    bool ok = text_words.size() == list.size();
+    for (int w = 0; ok && w < list.size(); ++w) {
+      ok = list.word_string(w) == text_words[w] && list.find(text_words[w]) == w;
+    }
+    std::cout << "  " << section.source << ", " << section.word_length << " letters: " << section.num_words << " words" << (ok ? "" : " DOESN'T MATCH THE TEXT FILE") << std::endl;
+    if (!ok) {
+      return 1;
+    }
+  }
+
+  for (const auto& source : sources) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::string> text_words = load_words_by_length(source).at(5);
+    auto parsed = std::chrono::steady_clock::now();
+    // what a tool starting up does: map the dictionary and unpack the list.
+    std::vector<std::string> packed_words;
+    if (auto fresh = PackedDictionary::open(out)) {
+      if (auto list = fresh->find_list(source, 5)) {
+	packed_words = list->to_strings();
+      }
+    }
+    auto unpacked = std::chrono::steady_clock::now();
+    std::cout << source << ": " << text_words.size() << " 5-letter words parsed in " << std::chrono::duration<double, std::micro>(parsed - start).count() << " us, "
+	      << packed_words.size() << " unpacked in " << std::chrono::duration<double, std::micro>(unpacked - parsed).count() << " us" << std::endl;
+  }
+  return 0;
+}
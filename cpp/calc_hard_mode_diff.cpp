@@ -1,21 +1,146 @@
 #include "utils.h"
+#include "hard_mode.h"
+#include "prefilter.h"
+#include "task_scheduler.h"
 
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <sstream>
 #include <vector>
 #include <fstream>
 
+// for every node of the hard-mode greedy tree, compare the best guess we're allowed in hard
+// mode with the best guess overall. nodes are independent, so each one is a task; finished
+// nodes are appended to hard_mode_diff.checkpoint as they complete so a crashed run resumes.
+//
+// checkpoint lines are: node id,number of solutions,entropy diff,hard mode guess
+// where the node id is the partition index taken at each level, joined with '-'.
+
+const char* kProgressFile = "hard_mode_diff.checkpoint";
+
+struct NodeResult {
+  int count;
+  double diff;
+  std::string guess;
+};
+
+std::map<std::string, NodeResult> load_progress() {
+  std::ifstream in(kProgressFile);
+  std::map<std::string, NodeResult> progress;
+  std::string str;
+  while (std::getline(in, str)) {
+    std::stringstream ss(str);
+    std::string id, count, diff, guess;
+    if (std::getline(ss, id, ',') && std::getline(ss, count, ',') && std::getline(ss, diff, ',') && std::getline(ss, guess)) {
+      progress[id] = {std::stoi(count), std::stod(diff), guess};
+    }
+  }
+  return progress;
+}
 
-void save_progress(const std::vector<std::pair<int, double>>& diffs) {
-  std::ofstream out("hard_mode_diff.checkpoint");
-  for (const auto& [count,diff] : diffs) {
-    out << count << "," << diff << std::endl;
+void save_progress(const std::map<std::string, NodeResult>& progress) {
+  std::ofstream out(kProgressFile);
+  for (const auto& [id, result] : progress) {
+    out << id << "," << result.count << "," << result.diff << "," << result.guess << std::endl;
   }
   out.close();
-
 }
 
-int main() {
+struct HardModeDiff {
+  const std::vector<std::string>& solution_list;
+  const std::vector<std::string>& guess_list;
+  std::vector<int> all_guess_idxs;
+  int max_depth;
+  TaskScheduler& scheduler;
+
+  std::mutex progress_mutex;
+  std::map<std::string, NodeResult> progress;
+  std::ofstream progress_out;
+  int num_done = 0;
+
+  // spawn a node for every partition of sols after the hard-mode guess `guess`.
+  void expand(const std::string& id, int depth, const std::string& guess, const std::vector<int>& sols, const HardModeGuesses& guesses) {
+    if (depth >= max_depth) {
+      return;
+    }
+    std::vector<std::vector<int>> sol_partitions = partition_space_for_word(guess, solution_list, sols);
+    std::vector<bool> wanted(sol_partitions.size());
+    for (int i = 0; i < sol_partitions.size(); ++i) {
+      wanted.at(i) = sol_partitions.at(i).size() > 1;
+    }
+    auto child_guesses = std::make_shared<std::vector<HardModeGuesses>>(guesses.split(guess, wanted));
+    // partition 0 is all green: solved, nothing to compare.
+    for (int i = 1; i < sol_partitions.size(); ++i) {
+      if (sol_partitions.at(i).empty()) {
+	continue;
+      }
+      std::string child_id = id.empty() ? std::to_string(i) : id + "-" + std::to_string(i);
+      auto child_sols = std::make_shared<std::vector<int>>(std::move(sol_partitions.at(i)));
+      scheduler.spawn([this, child_id, depth, child_sols, child_guesses, i]() {
+	visit(child_id, depth + 1, *child_sols, child_guesses->at(i));
+      });
+    }
+  }
+
+  void visit(const std::string& id, int depth, const std::vector<int>& sols, const HardModeGuesses& guesses) {
+    NodeResult result;
+    bool done;
+    {
+      std::lock_guard<std::mutex> lock(progress_mutex);
+      auto it = progress.find(id);
+      done = it != progress.end();
+      if (done) {
+	result = it->second;
+      }
+    }
+    if (!done) {
+      if (sols.size() == 1) {
+	// no diff in entropy if only one word remaining.
+	result = {1, 0.0, solution_list.at(sols.at(0))};
+      } else {
+	auto [constrained_guess, constrained_ent] = get_best_word_prefiltered(guess_list, guesses.allowed(), solution_list, sols, kPrefilterShortlist, /*exact=*/true);
+	auto [unconstrained_guess, unconstrained_ent] = get_best_word_prefiltered(guess_list, all_guess_idxs, solution_list, sols, kPrefilterShortlist, /*exact=*/true);
+	assert(unconstrained_ent >= constrained_ent);
+	result = {(int)sols.size(), unconstrained_ent - constrained_ent, constrained_guess};
+	if (unconstrained_ent > constrained_ent + 0.001) {
+	  std::stringstream ss;
+	  ss << "node " << id << " has remaining words:" << sols.size() << " for entropy: " << log2(sols.size()) << std::endl;
+	  ss << "best constrained guess is " << constrained_guess << " with entropy: " << constrained_ent << std::endl;
+	  ss << "best overall guess is " << unconstrained_guess << " with entropy: " << unconstrained_ent << std::endl;
+	  std::cout << ss.str();
+	}
+      }
+      std::lock_guard<std::mutex> lock(progress_mutex);
+      progress[id] = result;
+      progress_out << id << "," << result.count << "," << result.diff << "," << result.guess << std::endl;
+      if (++num_done % 20 == 0) {
+	std::cout << "finished " << num_done << " nodes" << std::endl;
+      }
+    }
+    if (sols.size() > 1) {
+      expand(id, depth, result.guess, sols, guesses);
+    }
+  }
+};
+
+int main(int argc, char** argv) {
+  // usage: ./calc_hard_mode_diff [--max-depth D] [--threads N] [--word-files]
+  // max depth 1 compares only the partitions of the first guess; the default is the full tree.
+  int max_depth = 100;
+  int num_threads = 0;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--max-depth" && i + 1 < argc) {
+      max_depth = std::stoi(argv[++i]);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      num_threads = std::stoi(argv[++i]);
+    } else if (arg == "--word-files") {
+      use_word_files();
+    }
+  }
 
   std::vector<std::string> solution_list = load_sol_words();
   std::vector<std::string> guess_list = load_guess_words();
@@ -29,42 +154,19 @@ int main() {
 
   auto [guess, _] = get_best_word(guess_list, all_guess_idxs, solution_list, all_solution_idxs, /*use_cache=*/true);
 
-  std::vector<std::vector<int>> sol_partitions = partition_space_for_word(guess, solution_list, all_solution_idxs);
-  std::vector<std::vector<int>> guess_partitions = partition_space_for_word(guess, guess_list, all_guess_idxs);
-
-  // for each partition, see what word we guess if we:
-  //   - have access to all the guess words or
-  //   - only have access to the remaining guess words.
-
-  // save, for each non-empty partition, how many words were in the partition and the diff in entropy there.
-  std::vector<std::pair<int, double>> diffs;
-
-  for (int i = 0; i < sol_partitions.size(); ++i) {
-    std::cout << "checking partition " << i << " of " << (sol_partitions.size() -1 ) << std::endl;
-    if (i % 20 == 0) {
-      save_progress(diffs);
-    }
-    if (sol_partitions.at(i).empty()) {
-      // skip empty partition or singular partition.
-      continue;
-    }
-
-    if (sol_partitions.at(i).size() == 1) {
-      // no diff in entropy if only one word remaining.
-      diffs.push_back(std::make_pair(1,0.0));
-      continue;
-    }
-
-    auto [constrained_guess, constrained_ent] = get_best_word(guess_list, guess_partitions.at(i), solution_list, sol_partitions.at(i), /*use_cache=*/false);
-    auto [unconstrained_guess, unconstrained_ent] = get_best_word(guess_list, all_guess_idxs, solution_list, sol_partitions.at(i), /*use_cache=*/false);
-    assert(unconstrained_ent >= constrained_ent);
-    diffs.push_back(std::make_pair(sol_partitions.at(i).size(), unconstrained_ent - constrained_ent));
-    if (unconstrained_ent > constrained_ent + 0.001) {
-      std::cout << "solution space has remaining words:" << sol_partitions.at(i).size() << " for entropy: " << log2(sol_partitions.at(i).size()) << std::endl;
-      std::cout << "best constrained guess is " << constrained_guess << " with entropy: " << constrained_ent << std::endl;
-      std::cout << "best overall guess is " << unconstrained_guess << " with entropy: " << unconstrained_ent << std::endl;
-    }
-  }
-  save_progress(diffs);
-
+  TaskScheduler scheduler(num_threads);
+  HardModeDiff search{solution_list, guess_list, all_guess_idxs, max_depth, scheduler};
+  search.progress = load_progress();
+  std::cout << "resuming with " << search.progress.size() << " nodes already compared" << std::endl;
+  // rewrite what we have (drops a half-written last line) and append from there.
+  save_progress(search.progress);
+  search.progress_out.open(kProgressFile, std::ios::app);
+
+  search.expand("", 0, guess, all_solution_idxs, HardModeGuesses(guess_list));
+  scheduler.wait();
+  search.progress_out.close();
+
+  // sorted by node id, so the finished file doesn't depend on scheduling.
+  save_progress(search.progress);
+  std::cout << "compared " << search.progress.size() << " nodes" << std::endl;
 }
@@ -1,20 +1,34 @@
 #include "utils.h"
 
 #include <iostream>
+#include <map>
 #include <numeric>
+#include <sstream>
 #include <vector>
 #include <fstream>
 
-std::vector<std::pair<int, double>> load_progress() {
+struct NodeDiff {
+  int depth;
+  int count;
+  double diff;
+};
+
+// reads hard_mode_diff.checkpoint: node id,count,diff,guess. the depth of a node is the
+// number of partition indices in its id.
+std::vector<NodeDiff> load_progress() {
   std::ifstream in("hard_mode_diff.checkpoint");
   if (!in.good()) {
     return {};
   }
   std::string str;
-  std::vector<std::pair<int, double>> diffs;
+  std::vector<NodeDiff> diffs;
   while (std::getline(in, str)) {
-    int comma_pos = str.find(',');
-    diffs.push_back(std::make_pair(std::stoi(str.substr(0, comma_pos)), std::stod(str.substr(comma_pos+1))));
+    std::stringstream ss(str);
+    std::string id, count, diff;
+    if (std::getline(ss, id, ',') && std::getline(ss, count, ',') && std::getline(ss, diff, ',')) {
+      int depth = std::count(id.begin(), id.end(), '-') + 1;
+      diffs.push_back({depth, std::stoi(count), std::stod(diff)});
+    }
   }
   in.close();
   return diffs;
@@ -25,21 +39,22 @@ int main() {
   // sanity checks.
   std::vector<std::string> solution_list = load_sol_words();
 
-  int total_counts = 0;
-  double total_advantage = 0.0;
-  int num_partitions_advantage = 0;
-  int num_solutions_advantage = 0;
-  for (const auto& [count,diff] : diffs) {
-    // std::cout << "count: " << count << " diff: " << diff << std::endl;
-    total_counts += count;
-    total_advantage += (count * diff);
-    if (diff > 0.001) {
-      num_partitions_advantage++;
-      num_solutions_advantage+= count;
+  // per depth: every level of a finished tree should account for the solutions not yet solved above it.
+  std::map<int, int> total_counts;
+  std::map<int, double> total_advantage;
+  std::map<int, int> num_solutions_advantage;
+  for (const auto& node : diffs) {
+    // std::cout << "count: " << node.count << " diff: " << node.diff << std::endl;
+    total_counts[node.depth] += node.count;
+    total_advantage[node.depth] += (node.count * node.diff);
+    if (node.diff > 0.001) {
+      num_solutions_advantage[node.depth] += node.count;
     }
   }
-  assert(total_counts == solution_list.size());
-  total_advantage /= (solution_list.size());
-  std::cout << "total advantage: " << total_advantage << std::endl;
-  std::cout << "number of solution words that have diff: " << num_solutions_advantage << " out of " << total_counts << std::endl;
+  assert(total_counts.empty() || total_counts.at(1) <= solution_list.size());
+  for (const auto& [depth, counts] : total_counts) {
+    std::cout << "depth " << depth << ":" << std::endl;
+    std::cout << "  total advantage: " << total_advantage.at(depth) / solution_list.size() << std::endl;
+    std::cout << "  number of solution words that have diff: " << num_solutions_advantage[depth] << " out of " << counts << std::endl;
+  }
 }
@@ -1,150 +1,325 @@
 #include "utils.h"
+#include "endgame.h"
+#include "guess_classes.h"
+#include "hard_mode.h"
+#include "progress.h"
+#include "task_scheduler.h"
 
+#include <algorithm>
+#include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <iostream>
 #include <numeric>
-#include <queue>
+#include <tuple>
 #include <vector>
 
-#include "assert.h"
+// a node of the greedy decision tree: the solutions and guesses still consistent with the
+// feedback along `path` (the partition index picked at each level). outside hard mode every
+// node shares the root's guesses. parent_classes are the guess classes of the parent node,
+// which this node's classes refine.
+struct Node {
+  Node(const std::vector<int>& constrained_solution_idxs, std::shared_ptr<const HardModeGuesses> guesses, std::shared_ptr<const GuessClasses> parent_classes, int depth, const std::vector<int>& path) : constrained_solution_idxs(constrained_solution_idxs), guesses(std::move(guesses)), parent_classes(std::move(parent_classes)), depth(depth), path(path) {}
+  std::vector<int> constrained_solution_idxs;
+  std::shared_ptr<const HardModeGuesses> guesses;
+  std::shared_ptr<const GuessClasses> parent_classes;
+  int depth;
+  std::vector<int> path;
+};
 
+// what we learned about one explored node. collected from all workers and printed in
+// BFS order at the end so the output doesn't depend on how tasks got scheduled.
+struct NodeReport {
+  int depth;
+  std::vector<int> path;
+  int num_solutions;
+  int num_guesses;
+  std::string guess;
+};
 
-std::vector<std::function<bool(const std::string&)>> resulting_constraints(const std::string& guess, const std::string& true_word) {
-  assert(guess.size() == 5);
-  assert(true_word.size() == 5);
+struct WorstCaseSearch {
+  const std::vector<std::string>& solution_list;
+  const std::vector<std::string>& guess_list;
+  TaskScheduler& scheduler;
+  bool hard_mode;
+  // counts solutions as their depth is settled.
+  ProgressReporter& progress;
 
-  std::vector<std::function<bool(const std::string&)>> constraints;
+  // depth in the high 32 bits, (INT32_MAX - solution idx) in the low 32 bits, so a single
+  // atomic max picks the deepest word and breaks ties by the smallest solution index.
+  std::atomic<int64_t> worst{0};
 
-  for (int i = 0; i < 5; ++i) {
-    char guess_letter = guess.at(i);
-    if (true_word.at(i) == guess_letter) {
-      constraints.push_back([i, guess_letter](const std::string& w) { return w.at(i) == guess_letter; });
-    } else if (true_word.find(guess_letter) != std::string::npos){
-      constraints.push_back([i, guess_letter](const std::string& w) { return w.at(i) != guess_letter && w.find(guess_letter) != std::string::npos;});
-    } else {
-      constraints.push_back([guess_letter](const std::string& w) { return w.find(guess_letter) == std::string::npos;});
+  std::mutex reports_mutex;
+  std::vector<NodeReport> reports;
+
+  // guesses scored across all nodes, and how many that would have been without the classes.
+  std::atomic<int64_t> num_scored{0};
+  std::atomic<int64_t> num_allowed{0};
+
+  void record_leaf(int depth, int sol_idx) {
+    atomic_max(worst, ((int64_t)depth << 32) | (int64_t)(INT32_MAX - sol_idx));
+    progress.add();
+  }
+
+  // spawn a task for every partition of node's solutions after guessing guess.
+  void expand_partitions(const Node& node, const std::string& guess, std::shared_ptr<const GuessClasses> classes);
+
+  void expand(const Node& node);
+};
+
+void WorstCaseSearch::expand_partitions(const Node& node, const std::string& guess, std::shared_ptr<const GuessClasses> classes) {
+  std::vector<std::vector<int>> partitions = partition_space_for_word(guess, solution_list, node.constrained_solution_idxs);
+  std::vector<bool> wanted(partitions.size());
+  for (int i = 0; i < partitions.size(); ++i) {
+    wanted.at(i) = partitions.at(i).size() > 1 && i != 0;
+  }
+  std::vector<HardModeGuesses> child_guesses;
+  if (hard_mode) {
+    child_guesses = node.guesses->split(guess, wanted);
+  }
+
+  for (int i = 0; i < partitions.size(); ++i) {
+    if (partitions.at(i).empty()) {
+      continue;
+    }
+    // partition 0 is all green: the guess itself was the answer.
+    if (i == 0) {
+      record_leaf(node.depth + 1, partitions.at(i).at(0));
+      continue;
     }
+    // size 1 partitions are solved by the next guess, no need to spawn a task for them.
+    if (partitions.at(i).size() == 1) {
+      record_leaf(node.depth + 2, partitions.at(i).at(0));
+      continue;
+    }
+    std::vector<int> path = node.path;
+    path.push_back(i);
+    auto guesses = hard_mode ? std::make_shared<const HardModeGuesses>(std::move(child_guesses.at(i))) : node.guesses;
+    auto child = std::make_shared<Node>(std::move(partitions.at(i)), guesses, classes, node.depth + 1, path);
+    scheduler.spawn([this, child]() { expand(*child); });
+  }
+}
+
+void WorstCaseSearch::expand(const Node& node) {
+  // if only one word left, update the "worst case" and stop exploring
+  if (node.constrained_solution_idxs.size() == 1) {
+    record_leaf(node.depth + 1, node.constrained_solution_idxs.at(0));
+    return;
+  }
+  // one guess per class is enough. in hard mode a class's representative may not be allowed
+  // any more while another member is, so classify the allowed guesses afresh (they're few).
+  auto classes = std::make_shared<const GuessClasses>(hard_mode ?
+    classify_guesses(guess_list, node.guesses->allowed(), solution_list, node.constrained_solution_idxs) :
+    refine_guess_classes(*node.parent_classes, guess_list, solution_list, node.constrained_solution_idxs));
+  num_scored += classes->representatives.size();
+  num_allowed += node.guesses->allowed().size();
+  // figure out what the max entropy guess (or the exact endgame guess) is from here.
+  auto [guess, _] = choose_guess(guess_list, classes->representatives, solution_list, node.constrained_solution_idxs, /*use_cache=*/false);
+  {
+    std::lock_guard<std::mutex> lock(reports_mutex);
+    reports.push_back({node.depth, node.path, (int)node.constrained_solution_idxs.size(), (int)node.guesses->allowed().size(), guess});
   }
-  return constraints;
+  expand_partitions(node, guess, classes);
 }
 
 void find_worst_case(const std::vector<std::string>& solution_list,
-		     const std::vector<std::string>& guess_list) {
+		     const std::vector<std::string>& guess_list,
+		     bool hard_mode,
+		     int num_threads) {
   // all words are still remaining;
   std::vector<int> constrained_solution_idxs(solution_list.size());
   std::iota(std::begin(constrained_solution_idxs), std::end(constrained_solution_idxs), 0);
+  auto all_guesses = std::make_shared<const HardModeGuesses>(guess_list);
 
-  std::vector<int> constrained_guess_idxs(guess_list.size());
-  std::iota(std::begin(constrained_guess_idxs), std::end(constrained_guess_idxs), 0);
-
-  auto [guess, _] = get_best_word(guess_list, constrained_guess_idxs, solution_list, constrained_solution_idxs, /*use_cache=*/true);
-  // TODO: need to constrain the guess list for each node also.
-  std::cout << "first guess: " << guess << std::endl;
-  std::vector<std::vector<int>> sol_partitions = partition_space_for_word(guess, solution_list, constrained_solution_idxs);
-  std::vector<std::vector<int>> guess_partitions = partition_space_for_word(guess, guess_list, constrained_guess_idxs);
-
-  // zip up the partitions.
-  assert(sol_partitions.size() == guess_partitions.size());
-  std::vector<std::pair<std::vector<int>, std::vector<int>>> partitions;
-  for (int i = 0; i < sol_partitions.size(); ++i) {
-    partitions.push_back(std::make_pair(sol_partitions.at(i), guess_partitions.at(i)));
-  }
-  // partitions.at(i).first is solutions, partitions.at(i).second is guesses.
-
-  // we need to break up each partition until the remaining sols are size 0 or 1.
-  int worst_case = 0;
-  std::string worst_case_str = "";
-
-  int cur_depth = 1;
-  // num partitions before
-  std::cout << "num partitions before " << partitions.size() << std::endl;
-  partitions.erase(std::remove_if(partitions.begin(), partitions.end(),  [](std::pair<std::vector<int>, std::vector<int>>& part) { return part.first.empty();}), partitions.end());
-  std::cout << "num partitions after " << partitions.size() << std::endl;
-  // num partitions after
-
-  struct Node {
-    Node(const std::vector<int>& constrained_solution_idxs, const std::vector<int>& constrained_guess_idxs, int depth) : constrained_solution_idxs(constrained_solution_idxs), constrained_guess_idxs(constrained_guess_idxs), depth(depth) {}
-    std::vector<int> constrained_solution_idxs;
-    std::vector<int> constrained_guess_idxs;
-    int depth;
-  };
-  // generate tree of partitions, use BFS to make sure we traverse in level-wise order. deepest partition will be worst case.
-  std::queue<Node> q;
-  for (const auto& part : partitions) {
-    q.push(Node(part.first, part.second, 1));
-  }
-
-  int explored_nodes_at_depth = 0;
-  while (!q.empty()) {
-    auto& front = q.front();
-    explored_nodes_at_depth++;
-    std::cout << "exploring node " << explored_nodes_at_depth << " with depth " << front.depth << " and " << front.constrained_solution_idxs.size() << " solution words remaining and " << front.constrained_guess_idxs.size() << " guess words remaining." <<  std::endl;
-    if (front.depth > cur_depth) {
-      // since we are traversing level-wise, will only be increasing.
-      cur_depth = front.depth;
-      explored_nodes_at_depth = 0;
-    }
-    // if only one word left, update the "worst case" and stop exploring
-    if (front.constrained_solution_idxs.size() == 1) {
-      if (front.depth + 1 > worst_case) {
-	worst_case = front.depth + 1;
-	worst_case_str = front.constrained_solution_idxs.at(0);
-      }
-      // std::cout << "only 1 word remaining, no need to explore any deeper" << std::endl;
-      q.pop();
-      continue;
-    }
-    // figure out what the min entropy guess is from here.
-    auto [guess, _] = get_best_word(guess_list, constrained_guess_idxs, solution_list, front.constrained_solution_idxs, /*use_cache=*/false);
-    std::vector<std::vector<int>> sol_partitions = partition_space_for_word(guess, solution_list, front.constrained_solution_idxs);
-    std::vector<std::vector<int>> guess_partitions = partition_space_for_word(guess, guess_list, front.constrained_guess_idxs);
-
-    // zip up the partitions.
-    assert(sol_partitions.size() == guess_partitions.size());
-    std::vector<std::pair<std::vector<int>, std::vector<int>>> partitions;
-    for (int i = 0; i < sol_partitions.size(); ++i) {
-      partitions.push_back(std::make_pair(sol_partitions.at(i), guess_partitions.at(i)));
+  auto [guess, _] = get_best_word(guess_list, all_guesses->allowed(), solution_list, constrained_solution_idxs, /*use_cache=*/true);
+  std::cout << "first guess: " << guess << (hard_mode ? " (hard mode)" : "") << std::endl;
+
+  // every partition is an independent subtree. expand them all as tasks; each task spawns
+  // its children, and idle workers steal from the busy ones.
+  TaskScheduler scheduler(num_threads);
+  std::cout << "expanding tree on " << scheduler.num_threads() << " threads" << std::endl;
+  auto progress = std::make_unique<ProgressReporter>("worst case", solution_list.size());
+  WorstCaseSearch search{solution_list, guess_list, scheduler, hard_mode, *progress};
+  auto root_classes = std::make_shared<const GuessClasses>(singleton_guess_classes(all_guesses->allowed()));
+  search.expand_partitions(Node(constrained_solution_idxs, all_guesses, root_classes, 0, {}), guess, root_classes);
+  scheduler.wait();
+  progress.reset();
+
+  // level-wise order, same as the old BFS.
+  std::sort(search.reports.begin(), search.reports.end(), [](const NodeReport& a, const NodeReport& b) {
+    return std::tie(a.depth, a.path) < std::tie(b.depth, b.path); });
+  for (const auto& report : search.reports) {
+    std::cout << "node at depth " << report.depth << " with " << report.num_solutions << " solution words remaining and " << report.num_guesses << " guess words remaining, guessing " << report.guess << std::endl;
+  }
+
+  std::cout << "scored " << search.num_scored << " guess classes instead of " << search.num_allowed << " guesses" << std::endl;
+
+  int64_t worst = search.worst.load();
+  std::cout << "max depth: " << (worst >> 32) << std::endl;
+  std::cout << "worst word: " << solution_list.at(INT32_MAX - (int)(worst & 0xffffffff)) << std::endl;
+}
+
+// most solutions that can possibly be told apart with `guesses_left` guesses: the last guess
+// has to be the word itself and every guess before it splits into at most 243 patterns.
+long long max_solvable(int guesses_left) {
+  long long n = 1;
+  for (int i = 1; i < guesses_left; ++i) {
+    n *= 243;
+    if (n > (1LL << 40)) {
+      break;
     }
+  }
+  return guesses_left <= 0 ? 0 : n;
+}
+
+struct Counterexample {
+  // (guess, feedback) pairs from the root down to the failing node.
+  std::vector<std::pair<std::string, int>> path;
+  std::vector<int> solution_idxs;
+  int guesses_left;
+};
+
+// does the greedy strategy solve every word in constrained_solution_idxs within guesses_left
+// more guesses? depth first, largest partition first, so a bad opener fails as early as possible.
+// if forced_guess is non-empty it is used instead of the greedy pick (the opener).
+bool certify_node(const std::vector<std::string>& solution_list,
+		  const std::vector<std::string>& guess_list,
+		  const HardModeGuesses& guesses,
+		  const GuessClasses& parent_classes,
+		  bool hard_mode,
+		  const std::vector<int>& constrained_solution_idxs,
+		  int guesses_left,
+		  const std::string& forced_guess,
+		  Counterexample& counterexample) {
+  if (constrained_solution_idxs.size() <= 1 && guesses_left >= 1) {
+    return true;
+  }
+  if (constrained_solution_idxs.size() > max_solvable(guesses_left)) {
+    counterexample.solution_idxs = constrained_solution_idxs;
+    counterexample.guesses_left = guesses_left;
+    return false;
+  }
+
+  // a forced guess needs no scoring, so its children can refine the parent's classes directly.
+  GuessClasses classes = parent_classes;
+  std::string guess = forced_guess;
+  if (guess.empty()) {
+    classes = hard_mode ?
+      classify_guesses(guess_list, guesses.allowed(), solution_list, constrained_solution_idxs) :
+      refine_guess_classes(parent_classes, guess_list, solution_list, constrained_solution_idxs);
+    guess = choose_guess(guess_list, classes.representatives, solution_list, constrained_solution_idxs, /*use_cache=*/false).first;
+  }
+  std::vector<std::vector<int>> partitions = partition_space_for_word(guess, solution_list, constrained_solution_idxs);
 
-    partitions.erase(std::remove_if(partitions.begin(), partitions.end(),  [](std::pair<std::vector<int>, std::vector<int>>& part) { return part.first.empty();}), partitions.end());
-    // also remove any partitions that are size 1
-    auto old_size = partitions.size();
-    auto it = std::partition(partitions.begin(), partitions.end(),  [](std::pair<std::vector<int>, std::vector<int>>& part) { return part.first.size() != 1;});
-    if (it != partitions.end()) {
-      std::cout << "removing some 1-size partitions early" << std::endl;
-      if (front.depth + 2 > worst_case) {
-	worst_case = front.depth + 2;
-	worst_case_str = solution_list.at(it->first.at(0));
-      }
-      partitions.erase(it, partitions.end());
+  // partition 0 is all green, i.e. the guess was the answer: solved with this guess.
+  std::vector<int> order;
+  for (int i = 1; i < partitions.size(); ++i) {
+    if (!partitions.at(i).empty()) {
+      order.push_back(i);
     }
+  }
+  std::stable_sort(order.begin(), order.end(), [&partitions](int a, int b) { return partitions.at(a).size() > partitions.at(b).size(); });
 
-    auto new_size = partitions.size();
-    if (old_size != new_size) {
-      std::cout << "went from " << old_size << " partitions to " << new_size << " partitions after removing size 1" << std::endl;
+  // check the cheap bound on every child before paying for any greedy search below.
+  for (int i : order) {
+    if (partitions.at(i).size() > max_solvable(guesses_left - 1)) {
+      counterexample.path.push_back(std::make_pair(guess, i));
+      counterexample.solution_idxs = partitions.at(i);
+      counterexample.guesses_left = guesses_left - 1;
+      return false;
     }
-    for  (const auto& part : partitions) {
-      q.push(Node(part.first, part.second, front.depth + 1));
+  }
+  for (int i : order) {
+    counterexample.path.push_back(std::make_pair(guess, i));
+    bool ok = hard_mode ?
+      certify_node(solution_list, guess_list, guesses.after_feedback(guess, i), classes, hard_mode, partitions.at(i), guesses_left - 1, "", counterexample) :
+      certify_node(solution_list, guess_list, guesses, classes, hard_mode, partitions.at(i), guesses_left - 1, "", counterexample);
+    if (!ok) {
+      return false;
     }
-    q.pop();
-    // do stuff here
+    counterexample.path.pop_back();
   }
+  return true;
+}
 
-  std::cout << "max depth: " << worst_case << std::endl;
-  std::cout << "worst word: " << worst_case_str << std::endl;
+// yes/no: does opener followed by greedy guesses solve every solution in at most k guesses?
+bool certify(const std::vector<std::string>& solution_list,
+	     const std::vector<std::string>& guess_list,
+	     const std::string& opener,
+	     bool hard_mode,
+	     int k) {
+  std::vector<int> all_solution_idxs(solution_list.size());
+  std::iota(std::begin(all_solution_idxs), std::end(all_solution_idxs), 0);
 
+  Counterexample counterexample;
+  HardModeGuesses all_guesses(guess_list);
+  if (certify_node(solution_list, guess_list, all_guesses, singleton_guess_classes(all_guesses.allowed()), hard_mode, all_solution_idxs, k, opener, counterexample)) {
+    std::cout << opener << " solves all " << solution_list.size() << " solutions within " << k << " guesses" << std::endl;
+    return true;
+  }
+  std::cout << opener << " can NOT solve every solution within " << k << " guesses. counterexample:" << std::endl;
+  for (const auto& [guess, partition_idx] : counterexample.path) {
+    std::cout << "  guess " << guess << " -> " << pattern_to_string(partition_idx) << std::endl;
+  }
+  std::cout << "  leaves " << counterexample.solution_idxs.size() << " solutions with " << counterexample.guesses_left << " guesses left:";
+  for (int i = 0; i < counterexample.solution_idxs.size() && i < 10; ++i) {
+    std::cout << " " << solution_list.at(counterexample.solution_idxs.at(i));
+  }
+  std::cout << std::endl;
+  return false;
 }
 
-int main() {
+int main(int argc, char** argv) {
+  // usage: ./calculate_worst_case [--hard] [--threads N] [--status-file FILE] [--word-files]   (default: every core)
+  // --status-file keeps a JSON line with the progress of the run in FILE (see progress.h).
+  //        ./calculate_worst_case --certify K [--opener WORD] [--hard]   (exit code 0 iff every solution takes <= K guesses, 2 if the opener isn't a guess)
+  int num_threads = 0;
+  int certify_k = 0;
+  bool hard_mode = false;
+  std::string opener;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--hard") {
+      hard_mode = true;
+    } else if (arg == "--status-file" && i + 1 < argc) {
+      report_status_to(argv[++i]);
+    } else if (arg == "--word-files") {
+      use_word_files();
+    } else if (arg == "--threads" && i + 1 < argc) {
+      num_threads = std::stoi(argv[++i]);
+    } else if (arg == "--certify" && i + 1 < argc) {
+      certify_k = std::stoi(argv[++i]);
+    } else if (arg == "--opener" && i + 1 < argc) {
+      opener = argv[++i];
+    }
+  }
   // std::map<std::string, double> entrop_dict = load_checkpoint();
   std::vector<std::string> sol_words = load_sol_words();
   std::vector<std::string> guess_words = load_guess_words();
 
-  find_worst_case(sol_words, guess_words);
+  if (certify_k > 0) {
+    if (opener.empty()) {
+      std::vector<int> all_sol_idxs(sol_words.size());
+      std::iota(std::begin(all_sol_idxs), std::end(all_sol_idxs), 0);
+      std::vector<int> all_guess_idxs(guess_words.size());
+      std::iota(std::begin(all_guess_idxs), std::end(all_guess_idxs), 0);
+      opener = get_best_word(guess_words, all_guess_idxs, sol_words, all_sol_idxs, /*use_cache=*/true).first;
+    }
+    // exit code 1 means "not certified", so a bad opener gets its own.
+    auto opener_it = std::find(guess_words.begin(), guess_words.end(), opener);
+    if (opener_it == guess_words.end()) {
+      std::cout << opener << " is not in the guess list" << std::endl;
+      return 2;
+    }
+    HardModeGuesses all_guesses(guess_words);
+    if (hard_mode && !std::binary_search(all_guesses.allowed().begin(), all_guesses.allowed().end(), (int)(opener_it - guess_words.begin()))) {
+      std::cout << opener << " is not an allowed hard mode guess" << std::endl;
+      return 2;
+    }
+    return certify(sol_words, guess_words, opener, hard_mode, certify_k) ? 0 : 1;
+  }
 
-  // assume we guess tares first.
-  // for (const auto& word : valid_words) {
-  //   auto constraints = resulting_constraints("tares", word);
-  // }
+  find_worst_case(sol_words, guess_words, hard_mode, num_threads);
 }
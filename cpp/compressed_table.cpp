@@ -0,0 +1,63 @@
+#include "compressed_table.h"
+
+#include <numeric>
+#include <queue>
+
+namespace {
+
+// plain huffman code lengths: repeatedly merge the two lightest subtrees.
+std::vector<int> unlimited_code_lengths(const std::vector<int64_t>& freqs) {
+  const int n = freqs.size();
+  if (n == 1) {
+    return {1};
+  }
+  // nodes 0..n-1 are the symbols, the rest are merged subtrees.
+  std::vector<int> parent(2 * n - 1, -1);
+  using Entry = std::pair<int64_t, int>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+  for (int i = 0; i < n; ++i) {
+    queue.push({freqs[i], i});
+  }
+  int next = n;
+  while (queue.size() > 1) {
+    auto [fa, a] = queue.top();
+    queue.pop();
+    auto [fb, b] = queue.top();
+    queue.pop();
+    parent[a] = parent[b] = next;
+    queue.push({fa + fb, next++});
+  }
+  std::vector<int> depth(2 * n - 1, 0);
+  for (int i = 2 * n - 3; i >= 0; --i) {
+    depth[i] = depth[parent[i]] + 1;
+  }
+  return std::vector<int>(depth.begin(), depth.begin() + n);
+}
+
+}  // namespace
+
+std::vector<int> huffman_code_lengths(const std::vector<int>& freqs, int max_length) {
+  std::vector<int64_t> scaled(freqs.begin(), freqs.end());
+  while (true) {
+    std::vector<int> lengths = unlimited_code_lengths(scaled);
+    if (*std::max_element(lengths.begin(), lengths.end()) <= max_length) {
+      return lengths;
+    }
+    // flatten the distribution until the rarest patterns get short enough codes.
+    for (auto& f : scaled) {
+      f = (f + 1) / 2;
+    }
+  }
+}
+
+void BitWriter::write(uint32_t code, int length) {
+  for (int i = length - 1; i >= 0; --i) {
+    if (num_bits_ / 8 + 8 >= bytes_.size()) {
+      bytes_.resize(bytes_.size() * 2 + 16);
+    }
+    if ((code >> i) & 1) {
+      bytes_[num_bits_ / 8] |= 0x80 >> (num_bits_ % 8);
+    }
+    ++num_bits_;
+  }
+}
@@ -0,0 +1,311 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "word_length.h"
+
+// guess x solution pattern table kept entropy coded in memory, for when the plain table (or
+// several of them) doesn't fit in the memory budget.
+//
+// a row is dominated by a handful of patterns (all grey, one yellow, ...) and a guess sees
+// only ~80 of the 243 5-letter patterns, at ~4.4 bits of entropy. so every row gets its own
+// canonical huffman code over the patterns it actually has, and the row is stored as a bit
+// stream of codes. identical rows (which come up with small or custom answer lists) are
+// stored once.
+//
+// rows are decoded a block of kCompressedBlockSize solutions at a time: each block's start is
+// indexed, so a sweep over a candidate subset only decodes the blocks holding candidates, and
+// only up to the last candidate in each, into a buffer that stays in L1. small blocks keep
+// that cheap for the few candidates left mid game; block starts are stored as 16-bit offsets
+// into superblocks so the index stays small too.
+
+constexpr int kCompressedBlockSize = 32;
+constexpr int kBlocksPerSuperblock = 32;
+// longest code we allow. also bounds a superblock to 32 * 32 * 16 bits, so block offsets fit
+// in 16 bits.
+constexpr int kMaxCodeLength = 16;
+// codes up to this long are decoded with one table lookup. it's filled for every row decoded,
+// so it has to stay small.
+constexpr int kFastCodeLength = 8;
+
+// code lengths for a length limited huffman code over freqs (all > 0).
+std::vector<int> huffman_code_lengths(const std::vector<int>& freqs, int max_length);
+
+// appends codes to a bit stream, most significant bit first. the stream is kept padded so a
+// decoder can read 8 bytes from anywhere inside it, also while it's being written.
+class BitWriter {
+ public:
+  void write(uint32_t code, int length);
+  uint64_t num_bits() const { return num_bits_; }
+  const std::vector<uint8_t>& bytes() const { return bytes_; }
+  // the stream, trimmed to its bits plus the 8 bytes of padding the decoder reads ahead.
+  std::vector<uint8_t> finish() {
+    bytes_.resize((num_bits_ + 7) / 8 + 8);
+    bytes_.shrink_to_fit();
+    return std::move(bytes_);
+  }
+
+ private:
+  std::vector<uint8_t> bytes_;
+  uint64_t num_bits_ = 0;
+};
+
+template <int N>
+class CompressedPatternTable {
+ public:
+  using pattern_t = typename WordTraits<N>::pattern_t;
+  static constexpr int P = WordTraits<N>::kNumPatterns;
+
+  // computes and compresses one row at a time, so the plain table never exists.
+  CompressedPatternTable(const std::vector<std::string>& guess_words, const std::vector<std::string>& sol_words)
+    : num_sols_(sol_words.size()), blocks_per_row_((sol_words.size() + kCompressedBlockSize - 1) / kCompressedBlockSize),
+      superblocks_per_row_((blocks_per_row_ + kBlocksPerSuperblock - 1) / kBlocksPerSuperblock) {
+    BitWriter writer;
+    std::unordered_map<uint64_t, std::vector<int>> rows_with_hash;
+    std::vector<pattern_t> row(num_sols_);
+    std::vector<pattern_t> decoded(num_sols_);
+    for (int g = 0; g < guess_words.size(); ++g) {
+      uint64_t hash = 14695981039346656037ull;
+      for (int s = 0; s < num_sols_; ++s) {
+	row[s] = calc_pattern_n<N>(guess_words[g].data(), sol_words[s].data());
+	hash = (hash ^ row[s]) * 1099511628211ull;
+      }
+      int unique_row = -1;
+      for (int candidate : rows_with_hash[hash]) {
+	decode_row(candidate, writer.bytes(), decoded.data());
+	if (decoded == row) {
+	  unique_row = candidate;
+	  break;
+	}
+      }
+      if (unique_row < 0) {
+	unique_row = codes_.size();
+	rows_with_hash[hash].push_back(unique_row);
+	encode_row(row, &writer);
+      }
+      row_of_guess_.push_back(unique_row);
+    }
+    stream_ = writer.finish();
+  }
+
+  int num_guesses() const { return row_of_guess_.size(); }
+  int num_sols() const { return num_sols_; }
+  int num_unique_rows() const { return codes_.size(); }
+
+  // bytes of everything kept, and what the plain table takes.
+  size_t stored_bytes() const {
+    return stream_.size() + symbols_.size() * sizeof(pattern_t) + codes_.size() * sizeof(RowCode) +
+      superblock_starts_.size() * sizeof(uint32_t) + block_starts_.size() * sizeof(uint16_t) + row_of_guess_.size() * sizeof(int);
+  }
+  size_t raw_bytes() const { return row_of_guess_.size() * (size_t)num_sols_ * sizeof(pattern_t); }
+
+  // decodes the patterns of guess against solutions [block * kCompressedBlockSize, ... + count)
+  // into out. count can stop short of the end of the block.
+  void decode_block(int guess, int block, int count, pattern_t* out) const {
+    const int r = row_of_guess_[guess];
+    const Decoder decoder(codes_[r], symbols_.data());
+    decoder.decode(stream_.data(), block_bit(r, block), count, out);
+  }
+
+  int pattern(int guess, int sol) const {
+    pattern_t block[kCompressedBlockSize];
+    decode_block(guess, sol / kCompressedBlockSize, sol % kCompressedBlockSize + 1, block);
+    return block[sol % kCompressedBlockSize];
+  }
+
+  // out[i] = pattern(guess, constrained_sol_idxs[i]), for ascending constrained_sol_idxs.
+  void gather(int guess, const std::vector<int>& constrained_sol_idxs, pattern_t* out) const {
+    for_each_block(row_of_guess_[guess], constrained_sol_idxs, [&](size_t i, pattern_t p) { out[i] = p; });
+  }
+
+  // calls f(guess idx, counts) for every guess in constrained_guess_idxs with its histogram over
+  // constrained_sol_idxs (3^N ints), which has to be ascending.
+  template <typename F>
+  void for_each_histogram(const std::vector<int>& constrained_guess_idxs, const std::vector<int>& constrained_sol_idxs, F&& f) const {
+    std::vector<int> counts(P);
+    for (const int g : constrained_guess_idxs) {
+      std::fill(counts.begin(), counts.end(), 0);
+      for_each_block(row_of_guess_[g], constrained_sol_idxs, [&](size_t, pattern_t p) { counts[p]++; });
+      f(g, counts.data());
+    }
+  }
+
+ private:
+  struct RowCode {
+    uint64_t bit_start;
+    // the row's patterns in code order start at symbols_[first_symbol].
+    uint32_t first_symbol;
+    // how many codes there are of each length.
+    uint16_t length_counts[kMaxCodeLength + 1];
+  };
+
+  // canonical huffman decoding: codes of one length are consecutive numbers, so a code of
+  // length l is the one whose top l bits fall in [first[l], first[l] + count[l]). short codes,
+  // which are nearly all of them, are looked up in a table instead.
+  class Decoder {
+   public:
+    Decoder(const RowCode& code, const pattern_t* all_symbols) : symbols_(all_symbols + code.first_symbol) {
+      uint32_t first = 0;
+      int index = 0;
+      std::fill(std::begin(fast_), std::end(fast_), 0);
+      for (int l = 1; l <= kMaxCodeLength; ++l) {
+	first_[l] = first;
+	count_[l] = code.length_counts[l];
+	index_[l] = index;
+	if (l <= kFastCodeLength) {
+	  // every kFastCodeLength bit prefix starting with one of these codes.
+	  const int spread = kFastCodeLength - l;
+	  for (uint32_t c = 0; c < count_[l]; ++c) {
+	    const uint32_t entry = (uint32_t)symbols_[index + c] << 8 | l;
+	    std::fill(fast_ + ((first + c) << spread), fast_ + ((first + c + 1) << spread), entry);
+	  }
+	}
+	index += count_[l];
+	first = (first + count_[l]) << 1;
+      }
+    }
+
+    void decode(const uint8_t* stream, uint64_t bit, int count, pattern_t* out) const {
+      // the stream from bit on, left aligned, with avail of its bits valid.
+      const uint8_t* next = stream + bit / 8;
+      uint64_t buffer = load(next) << (bit % 8);
+      int avail = 64 - bit % 8;
+      next += 8;
+      for (int i = 0; i < count; ++i) {
+	if (avail < kMaxCodeLength) {
+	  // top up from the byte holding the first bit we don't have yet.
+	  next -= (avail + 7) / 8;
+	  const int skip = (8 - avail % 8) % 8;
+	  buffer = load(next) << skip;
+	  avail = 64 - skip;
+	  next += 8;
+	}
+	const uint32_t peek = buffer >> (64 - kMaxCodeLength);
+	const uint32_t entry = fast_[peek >> (kMaxCodeLength - kFastCodeLength)];
+	int l;
+	if (entry) {
+	  out[i] = entry >> 8;
+	  l = entry & 0xff;
+	} else {
+	  l = kFastCodeLength + 1;
+	  while ((peek >> (kMaxCodeLength - l)) - first_[l] >= count_[l]) {
+	    ++l;
+	  }
+	  out[i] = symbols_[index_[l] + (peek >> (kMaxCodeLength - l)) - first_[l]];
+	}
+	buffer <<= l;
+	avail -= l;
+      }
+    }
+
+   private:
+    static uint64_t load(const uint8_t* p) {
+      uint64_t word;
+      memcpy(&word, p, 8);
+      return __builtin_bswap64(word);
+    }
+
+    const pattern_t* symbols_;
+    uint32_t first_[kMaxCodeLength + 1];
+    uint32_t count_[kMaxCodeLength + 1];
+    int index_[kMaxCodeLength + 1];
+    // pattern << 8 | code length, 0 for prefixes of longer codes.
+    uint32_t fast_[1 << kFastCodeLength];
+  };
+
+  uint64_t block_bit(int r, int b) const {
+    return codes_[r].bit_start + superblock_starts_[(size_t)r * superblocks_per_row_ + b / kBlocksPerSuperblock] + block_starts_[(size_t)r * blocks_per_row_ + b];
+  }
+
+  // calls f(i, pattern) for every solution in constrained_sol_idxs (ascending), decoding only
+  // the blocks they're in, up to the last one in each.
+  template <typename F>
+  void for_each_block(int r, const std::vector<int>& constrained_sol_idxs, F&& f) const {
+    const Decoder decoder(codes_[r], symbols_.data());
+    pattern_t block[kCompressedBlockSize];
+    size_t i = 0;
+    while (i < constrained_sol_idxs.size()) {
+      const int b = constrained_sol_idxs[i] / kCompressedBlockSize;
+      const int block_start = b * kCompressedBlockSize;
+      size_t end = i;
+      while (end < constrained_sol_idxs.size() && constrained_sol_idxs[end] < block_start + kCompressedBlockSize) {
+	++end;
+      }
+      decoder.decode(stream_.data(), block_bit(r, b), constrained_sol_idxs[end - 1] - block_start + 1, block);
+      for (; i < end; ++i) {
+	f(i, block[constrained_sol_idxs[i] - block_start]);
+      }
+    }
+  }
+
+  void decode_row(int r, const std::vector<uint8_t>& stream, pattern_t* out) const {
+    const Decoder decoder(codes_[r], symbols_.data());
+    decoder.decode(stream.data(), codes_[r].bit_start, num_sols_, out);
+  }
+
+  void encode_row(const std::vector<pattern_t>& row, BitWriter* writer) {
+    std::vector<int> freq_of(P);
+    for (const pattern_t p : row) {
+      freq_of[p]++;
+    }
+    std::vector<pattern_t> symbols;
+    std::vector<int> freqs;
+    for (int p = 0; p < P; ++p) {
+      if (freq_of[p]) {
+	symbols.push_back(p);
+	freqs.push_back(freq_of[p]);
+      }
+    }
+    std::vector<int> lengths = huffman_code_lengths(freqs, kMaxCodeLength);
+
+    RowCode code = {};
+    code.bit_start = writer->num_bits();
+    code.first_symbol = symbols_.size();
+    // canonical order: by length, then pattern.
+    std::vector<int> order(symbols.size());
+    for (int i = 0; i < order.size(); ++i) {
+      order[i] = i;
+      code.length_counts[lengths[i]]++;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return lengths[a] < lengths[b]; });
+    std::vector<uint32_t> code_of(P);
+    std::vector<int> length_of(P);
+    uint32_t next = 0;
+    int length = lengths[order[0]];
+    for (int i : order) {
+      next <<= lengths[i] - length;
+      length = lengths[i];
+      code_of[symbols[i]] = next++;
+      length_of[symbols[i]] = length;
+      symbols_.push_back(symbols[i]);
+    }
+    codes_.push_back(code);
+
+    for (int s = 0; s < num_sols_; ++s) {
+      if (s % (kCompressedBlockSize * kBlocksPerSuperblock) == 0) {
+	superblock_starts_.push_back(writer->num_bits() - code.bit_start);
+      }
+      if (s % kCompressedBlockSize == 0) {
+	block_starts_.push_back(writer->num_bits() - code.bit_start - superblock_starts_.back());
+      }
+      writer->write(code_of[row[s]], length_of[row[s]]);
+    }
+  }
+
+  int num_sols_;
+  int blocks_per_row_;
+  int superblocks_per_row_;
+  std::vector<uint8_t> stream_;
+  std::vector<pattern_t> symbols_;
+  std::vector<RowCode> codes_;
+  // bit offset of every superblock from the start of its row, and of every block from the start
+  // of its superblock.
+  std::vector<uint32_t> superblock_starts_;
+  std::vector<uint16_t> block_starts_;
+  std::vector<int> row_of_guess_;
+};
@@ -0,0 +1,237 @@
+#include "dictionary.h"
+#include "word_length.h"
+
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kMagic[8] = {'W', 'O', 'R', 'D', 'D', 'I', 'C', 'T'};
+
+uint64_t checksum(const uint8_t* data, size_t size) {
+  uint64_t h = 14695981039346656037ull ^ size;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    memcpy(&word, data + i, 8);
+    h = (h ^ word) * 1099511628211ull;
+  }
+  for (; i < size; ++i) {
+    h = (h ^ data[i]) * 1099511628211ull;
+  }
+  return h;
+}
+
+size_t align8(size_t offset) {
+  return (offset + 7) / 8 * 8;
+}
+
+// whether every section's words and index lie inside the file, after the section table. only the
+// table is read, so a corrupted file is turned away without touching the rest of the mapping;
+// the index entries themselves are checked as find() probes them.
+bool sections_in_bounds(const uint8_t* base, size_t size) {
+  const auto* header = (const DictionaryHeader*)base;
+  const auto* sections = (const DictionarySection*)(base + sizeof(DictionaryHeader));
+  const size_t data_start = sizeof(DictionaryHeader) + (size_t)header->num_sections * sizeof(DictionarySection);
+  for (uint32_t i = 0; i < header->num_sections; ++i) {
+    const DictionarySection& section = sections[i];
+    if (section.word_length < 1 || section.word_length > (uint32_t)kMaxWordLength || section.index_buckets == 0 ||
+	(section.index_buckets & (section.index_buckets - 1)) != 0 || section.index_offset % sizeof(uint32_t) != 0) {
+      return false;
+    }
+    if (section.words_offset < data_start || section.words_offset > size ||
+	(size - section.words_offset) / section.word_length < section.num_words) {
+      return false;
+    }
+    if (section.index_offset < data_start || section.index_offset > size ||
+	(size - section.index_offset) / sizeof(uint32_t) < section.index_buckets) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+uint32_t hash_word(const char* word, int length) {
+  uint32_t h = 2166136261u;
+  for (int i = 0; i < length; ++i) {
+    h = (h ^ (uint8_t)word[i]) * 16777619u;
+  }
+  return h;
+}
+
+int PackedWordList::find(const std::string& word) const {
+  if (word.size() != word_length_) {
+    return -1;
+  }
+  uint32_t b = hash_word(word.data(), word_length_) & index_mask_;
+  for (uint32_t probes = 0; probes <= index_mask_; ++probes, b = (b + 1) & index_mask_) {
+    // an entry past the words only comes from a corrupted file.
+    if (index_[b] == 0 || index_[b] > (uint32_t)num_words_) {
+      return -1;
+    }
+    if (memcmp(this->word(index_[b] - 1), word.data(), word_length_) == 0) {
+      return index_[b] - 1;
+    }
+  }
+  return -1;
+}
+
+std::vector<std::string> PackedWordList::to_strings() const {
+  std::vector<std::string> words;
+  words.reserve(num_words_);
+  for (int i = 0; i < num_words_; ++i) {
+    words.emplace_back(word(i), word_length_);
+  }
+  return words;
+}
+
+std::unique_ptr<PackedDictionary> PackedDictionary::open(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  void* mapping = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size >= sizeof(DictionaryHeader)) {
+    mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return nullptr;
+  }
+  const auto* header = (const DictionaryHeader*)mapping;
+  if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kDictionaryVersion || header->file_size != st.st_size ||
+      sizeof(DictionaryHeader) + (size_t)header->num_sections * sizeof(DictionarySection) > st.st_size ||
+      !sections_in_bounds((const uint8_t*)mapping, st.st_size)) {
+    munmap(mapping, st.st_size);
+    return nullptr;
+  }
+  return std::unique_ptr<PackedDictionary>(new PackedDictionary((const uint8_t*)mapping, st.st_size));
+}
+
+PackedDictionary::PackedDictionary(const uint8_t* base, size_t size)
+  : base_(base), size_(size), header_((const DictionaryHeader*)base), sections_((const DictionarySection*)(base + sizeof(DictionaryHeader))) {}
+
+PackedDictionary::~PackedDictionary() {
+  munmap((void*)base_, size_);
+}
+
+std::optional<PackedWordList> PackedDictionary::find_list(const std::string& source, int word_length) const {
+  for (int i = 0; i < header_->num_sections; ++i) {
+    const DictionarySection& section = sections_[i];
+    if (section.word_length != word_length || strncmp(section.source, source.c_str(), sizeof(section.source)) != 0) {
+      continue;
+    }
+    struct stat st;
+    if (stat(source.c_str(), &st) == 0 && (st.st_size != section.source_size || st.st_mtime != section.source_mtime)) {
+      return std::nullopt;
+    }
+    return list(i);
+  }
+  return std::nullopt;
+}
+
+bool PackedDictionary::verify() const {
+  return checksum(base_ + sizeof(DictionaryHeader), size_ - sizeof(DictionaryHeader)) == header_->checksum;
+}
+
+bool write_dictionary(const std::string& path, const std::vector<std::string>& sources) {
+  std::vector<DictionarySection> sections;
+  std::vector<std::vector<std::string>> section_words;
+  for (const auto& source : sources) {
+    struct stat st;
+    std::ifstream in(source);
+    if (source.size() >= sizeof(DictionarySection::source) || stat(source.c_str(), &st) != 0 || !in.good()) {
+      return false;
+    }
+    std::vector<std::vector<std::string>> words(kMaxWordLength + 1);
+    std::string str;
+    while (std::getline(in, str)) {
+      if (str.size() <= kMaxWordLength) {
+	words[str.size()].push_back(str);
+      }
+    }
+    for (int len = 1; len <= kMaxWordLength; ++len) {
+      if (words[len].empty()) {
+	continue;
+      }
+      DictionarySection section = {};
+      strncpy(section.source, source.c_str(), sizeof(section.source) - 1);
+      section.source_size = st.st_size;
+      section.source_mtime = st.st_mtime;
+      section.word_length = len;
+      section.num_words = words[len].size();
+      // at most half full, so probes stay short.
+      section.index_buckets = 1;
+      while (section.index_buckets < 2 * words[len].size()) {
+	section.index_buckets *= 2;
+      }
+      sections.push_back(section);
+      section_words.push_back(std::move(words[len]));
+    }
+  }
+
+  size_t offset = sizeof(DictionaryHeader) + sections.size() * sizeof(DictionarySection);
+  for (auto& section : sections) {
+    section.words_offset = offset;
+    section.index_offset = align8(offset + (size_t)section.num_words * section.word_length);
+    offset = section.index_offset + section.index_buckets * sizeof(uint32_t);
+  }
+  std::vector<uint8_t> file(offset);
+  for (int i = 0; i < sections.size(); ++i) {
+    const auto& section = sections[i];
+    char* packed = (char*)file.data() + section.words_offset;
+    uint32_t* index = (uint32_t*)(file.data() + section.index_offset);
+    for (uint32_t w = 0; w < section.num_words; ++w) {
+      const std::string& word = section_words[i][w];
+      memcpy(packed + (size_t)w * section.word_length, word.data(), section.word_length);
+      uint32_t b = hash_word(word.data(), section.word_length) & (section.index_buckets - 1);
+      while (index[b] != 0) {
+	b = (b + 1) & (section.index_buckets - 1);
+      }
+      index[b] = w + 1;
+    }
+  }
+  memcpy(file.data() + sizeof(DictionaryHeader), sections.data(), sections.size() * sizeof(DictionarySection));
+  DictionaryHeader header = {};
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kDictionaryVersion;
+  header.num_sections = sections.size();
+  header.file_size = file.size();
+  header.checksum = checksum(file.data() + sizeof(DictionaryHeader), file.size() - sizeof(DictionaryHeader));
+  memcpy(file.data(), &header, sizeof(header));
+
+  // write then rename, so tools starting meanwhile never map half a file. the temporary name is
+  // per process, like the other table writers', so two build_dict runs don't write into each other.
+  const std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+  std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+  out.write((const char*)file.data(), file.size());
+  out.close();
+  if (!out.good() || rename(tmp_path.c_str(), path.c_str()) != 0) {
+    remove(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool load_words_from_dictionary(const std::string& filename, int word_length, std::vector<std::string>* words) {
+  // mapped once per process.
+  static const std::unique_ptr<PackedDictionary> dictionary = PackedDictionary::open(kDictionaryFile);
+  if (!dictionary) {
+    return false;
+  }
+  auto list = dictionary->find_list(filename, word_length);
+  if (!list) {
+    return false;
+  }
+  *words = list->to_strings();
+  return true;
+}
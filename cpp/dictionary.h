@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// binary word lists, written by build_dict so the tools don't have to parse sowpods.txt (267k
+// lines) at every startup. the file holds, for every source list and word length, the words
+// packed at a fixed width in their original order (so indices match the text lists) and an
+// open addressing hash index over them. loading is an mmap; the only parsing is checking the
+// header.
+//
+// each section remembers the size and modification time of the text file it came from, and
+// is ignored once that file changes, so a stale dictionary can't shadow an edited list.
+
+constexpr const char* kDictionaryFile = "words.dict";
+constexpr uint32_t kDictionaryVersion = 1;
+
+struct DictionaryHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_sections;
+  uint64_t file_size;
+  // of everything after the header, checked by build_dict --verify.
+  uint64_t checksum;
+};
+
+struct DictionarySection {
+  // the text file the words came from, as passed to build_dict.
+  char source[48];
+  uint64_t source_size;
+  int64_t source_mtime;
+  uint32_t word_length;
+  uint32_t num_words;
+  uint64_t words_offset;
+  // index_buckets (a power of two) uint32 word index + 1, 0 for empty.
+  uint64_t index_offset;
+  uint32_t index_buckets;
+  uint32_t unused;
+};
+
+// the words of one length from one list, straight out of the mapping.
+class PackedWordList {
+ public:
+  PackedWordList(const DictionarySection& section, const uint8_t* base)
+    : words_((const char*)base + section.words_offset), index_((const uint32_t*)(base + section.index_offset)),
+      word_length_(section.word_length), num_words_(section.num_words), index_mask_(section.index_buckets - 1) {}
+
+  int size() const { return num_words_; }
+  int word_length() const { return word_length_; }
+  // not null terminated.
+  const char* word(int i) const { return words_ + (size_t)i * word_length_; }
+  std::string word_string(int i) const { return std::string(word(i), word_length_); }
+
+  // index of word, or -1.
+  int find(const std::string& word) const;
+
+  std::vector<std::string> to_strings() const;
+
+ private:
+  const char* words_;
+  const uint32_t* index_;
+  int word_length_;
+  int num_words_;
+  uint32_t index_mask_;
+};
+
+class PackedDictionary {
+ public:
+  // nullptr if path is missing or isn't a dictionary of this version.
+  static std::unique_ptr<PackedDictionary> open(const std::string& path);
+  ~PackedDictionary();
+
+  // the words of this length from source, if the dictionary has them and source hasn't changed
+  // since (or no longer exists).
+  std::optional<PackedWordList> find_list(const std::string& source, int word_length) const;
+
+  const DictionaryHeader& header() const { return *header_; }
+  const DictionarySection& section(int i) const { return sections_[i]; }
+  PackedWordList list(int i) const { return PackedWordList(sections_[i], base_); }
+
+  // recomputes the checksum.
+  bool verify() const;
+
+ private:
+  PackedDictionary(const uint8_t* base, size_t size);
+
+  const uint8_t* base_;
+  size_t size_;
+  const DictionaryHeader* header_;
+  const DictionarySection* sections_;
+};
+
+uint32_t hash_word(const char* word, int length);
+
+// writes the words of every given text file to path. false if a file can't be read or path
+// can't be written.
+bool write_dictionary(const std::string& path, const std::vector<std::string>& sources);
+
+// the word_length-letter words of filename from kDictionaryFile, if it's there and up to date
+// for filename.
+bool load_words_from_dictionary(const std::string& filename, int word_length, std::vector<std::string>* words);
+
+// word lists compiled into the executables: build_dict --header writes them to
+// embedded_words.h, and building with -DWORDLE_EMBEDDED makes the loaders use them.
+struct EmbeddedWordList {
+  const char* source;
+  int word_length;
+  int num_words;
+  // packed like a dictionary section.
+  const char* words;
+};
@@ -0,0 +1,300 @@
+#include "endgame.h"
+#include "prefilter.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <unordered_set>
+
+EndgameSolver::EndgameSolver(const std::vector<std::string>& guess_words, const std::vector<int>& constrained_guess_idxs, const std::vector<std::string>& sol_words, const std::vector<int>& constrained_sol_idxs, const SearchLimits* limits, int shortlist)
+  : num_sols_(constrained_sol_idxs.size()), candidate_class_(constrained_sol_idxs.size(), -1), limits_(limits), shortlist_(shortlist) {
+  assert(num_sols_ <= 32);
+  // letters that appear in any candidate. a guess with none of them is all grey everywhere.
+  uint32_t candidate_letters = 0;
+  for (int s : constrained_sol_idxs) {
+    for (char c : sol_words.at(s)) {
+      candidate_letters |= 1u << (c - 'a');
+    }
+  }
+  std::vector<const char*> candidates;
+  for (int s : constrained_sol_idxs) {
+    candidates.push_back(sol_words.at(s).data());
+  }
+  // collapse guesses that split the candidates identically; only one of each needs trying.
+  std::unordered_set<std::string> seen;
+  seen.reserve(constrained_guess_idxs.size());
+  std::string signature(num_sols_, 0);
+  for (int g : constrained_guess_idxs) {
+    const std::string& guess = guess_words.at(g);
+    uint32_t guess_letters = 0;
+    for (char c : guess) {
+      guess_letters |= 1u << (c - 'a');
+    }
+    if ((guess_letters & candidate_letters) == 0) {
+      continue;
+    }
+    int candidate = -1;
+    for (int i = 0; i < num_sols_; ++i) {
+      signature[i] = calc_pattern_n<5>(guess.data(), candidates[i]);
+      if (signature[i] == 0) {
+	candidate = i;
+      }
+    }
+    if (!seen.insert(signature).second) {
+      continue;
+    }
+    if (candidate >= 0) {
+      candidate_class_.at(candidate) = class_guess_idxs_.size();
+    }
+    class_guess_idxs_.push_back(g);
+    patterns_.insert(patterns_.end(), signature.begin(), signature.end());
+  }
+}
+
+namespace {
+// cheapest possible total for n words: one guessed right away, the rest one guess later.
+int lower_bound(int n) {
+  return n <= 1 ? n : 2 * n - 1;
+}
+}
+
+int EndgameSolver::solve(uint32_t mask, int cutoff, const std::vector<int>& classes) {
+  int n = __builtin_popcount(mask);
+  if (n <= 1) {
+    return n;
+  }
+  if (lower_bound(n) >= cutoff) {
+    return lower_bound(n);
+  }
+  auto it = memo_.find(mask);
+  if (it != memo_.end() && (it->second.settled || it->second.value >= cutoff)) {
+    return it->second.value;
+  }
+  // out of time: claim nothing below cutoff, so no caller takes a guess through here.
+  if (aborted_ || (limits_ && limits_->expired())) {
+    aborted_ = true;
+    return std::max(cutoff, lower_bound(n));
+  }
+
+  // a candidate that splits the others into singletons hits the lower bound; check those
+  // (cheap, at most n of them) before looking at every class.
+  for (uint32_t m = mask; m; m &= m - 1) {
+    int c = candidate_class_.at(__builtin_ctz(m));
+    if (c < 0) {
+      continue;
+    }
+    const uint8_t* row = patterns_.data() + (size_t)c * num_sols_;
+    bool seen[243] = {false};
+    bool perfect = true;
+    for (uint32_t r = mask; r && perfect; r &= r - 1) {
+      uint8_t p = row[__builtin_ctz(r)];
+      perfect = !seen[p];
+      seen[p] = true;
+    }
+    if (perfect) {
+      memo_[mask] = {lower_bound(n), c, true};
+      return lower_bound(n);
+    }
+  }
+
+  // -p log2 p of a part with i of the n words.
+  double entropy_terms[33];
+  for (int i = 1; i <= n; ++i) {
+    entropy_terms[i] = -(double)i / n * log2((double)i / n);
+  }
+  struct Split {
+    int guess_class;
+    double entropy;
+    bool is_candidate;
+    int bound;
+    int num_parts;
+    uint32_t parts[32];
+    int part_bounds[32];
+  };
+  uint32_t parts[243];
+  // which call to split_by last used each pattern, so parts[] never needs clearing.
+  int last_use[243];
+  std::fill(last_use, last_use + 243, -1);
+  int num_uses = 0;
+  uint8_t used[32];
+  // the split guessing class c makes of mask, with the parts in order of their lowest word.
+  auto split_by = [&](int c, Split* split) {
+    const uint8_t* row = patterns_.data() + (size_t)c * num_sols_;
+    int num_used = 0;
+    ++num_uses;
+    for (uint32_t m = mask; m; m &= m - 1) {
+      int s = __builtin_ctz(m);
+      uint8_t p = row[s];
+      if (last_use[p] != num_uses) {
+	last_use[p] = num_uses;
+	used[num_used++] = p;
+	parts[p] = 0;
+      }
+      parts[p] |= 1u << s;
+    }
+    split->guess_class = c;
+    split->entropy = 0.0;
+    split->is_candidate = false;
+    split->num_parts = 0;
+    for (int u = 0; u < num_used; ++u) {
+      uint32_t part = parts[used[u]];
+      split->entropy += entropy_terms[__builtin_popcount(part)];
+      if (used[u] == 0) {
+	split->is_candidate = true;
+      } else {
+	split->parts[split->num_parts++] = part;
+      }
+    }
+  };
+
+  // one pass over the classes for their entropies. a class that learns nothing about mask learns
+  // nothing about its subsets either, and one that splits mask like an earlier class can't split
+  // a subset differently, so only the rest are ranked and handed down. splits are looked up by a
+  // hash of their parts; on a hit the earlier class's split is redone and compared exactly.
+  struct Ranked {
+    double entropy;
+    int guess_class;
+    bool is_candidate;
+  };
+  std::vector<Ranked> ranked;
+  std::vector<int> useful_classes;
+  std::unordered_map<uint64_t, int> seen_splits;
+  Split split;
+  Split earlier;
+  auto same_split = [](const Split& a, const Split& b) {
+    return a.is_candidate == b.is_candidate && a.num_parts == b.num_parts && std::equal(a.parts, a.parts + a.num_parts, b.parts);
+  };
+  for (int c : classes) {
+    split_by(c, &split);
+    if (split.num_parts == 1 && !split.is_candidate) {
+      // learns nothing.
+      continue;
+    }
+    uint64_t hash = split.is_candidate;
+    for (int i = 0; i < split.num_parts; ++i) {
+      hash = (hash ^ split.parts[i]) * 0x9e3779b97f4a7c15ull;
+      hash ^= hash >> 32;
+    }
+    auto [seen, inserted] = seen_splits.emplace(hash, c);
+    if (!inserted) {
+      split_by(seen->second, &earlier);
+      if (same_split(split, earlier)) {
+	continue;
+      }
+      // a real collision: keep the class, the map just can't catch its duplicates.
+    }
+    useful_classes.push_back(c);
+    ranked.push_back({split.entropy, c, split.is_candidate});
+  }
+  // above kEndgameExactSize only the best few splits by entropy are worth expanding, plus the
+  // candidates in case the game can end right here.
+  if (n > kEndgameExactSize && shortlist_ > 0 && ranked.size() > shortlist_) {
+    std::partial_sort(ranked.begin(), ranked.begin() + shortlist_, ranked.end(), [](const Ranked& a, const Ranked& b) {
+      return a.entropy != b.entropy ? a.entropy > b.entropy : a.guess_class < b.guess_class; });
+    ranked.erase(std::remove_if(ranked.begin() + shortlist_, ranked.end(), [](const Ranked& r) { return !r.is_candidate; }), ranked.end());
+  }
+  // then go in order of increasing bound, so the first few tries usually settle it and the
+  // cutoff bites early.
+  std::vector<Split> splits(ranked.size());
+  for (int i = 0; i < ranked.size(); ++i) {
+    Split& split = splits[i];
+    split_by(ranked[i].guess_class, &split);
+    split.bound = n;
+    for (int j = 0; j < split.num_parts; ++j) {
+      auto known = memo_.find(split.parts[j]);
+      split.part_bounds[j] = known != memo_.end() ? known->second.value : lower_bound(__builtin_popcount(split.parts[j]));
+      split.bound += split.part_bounds[j];
+    }
+  }
+  std::sort(splits.begin(), splits.end(), [](const Split& a, const Split& b) {
+    return a.bound != b.bound ? a.bound < b.bound : a.guess_class < b.guess_class; });
+
+  int best = cutoff;
+  int best_class = -1;
+  for (const Split& split : splits) {
+    if (split.bound >= best) {
+      break;
+    }
+    // swap each part's bound for its cost, giving up once the total can't beat the best so far.
+    int total = split.bound;
+    for (int i = 0; i < split.num_parts && total < best; ++i) {
+      total -= split.part_bounds[i];
+      total += solve(split.parts[i], best - total, useful_classes);
+    }
+    if (total < best) {
+      best = total;
+      best_class = split.guess_class;
+      if (mask == root_) {
+	root_best_class_ = best_class;
+	root_best_total_ = best;
+      }
+    }
+  }
+  // values below cutoff are still achievable after an abort, but no longer the minimum.
+  if (aborted_) {
+    return best;
+  }
+  if (best < cutoff) {
+    memo_[mask] = {best, best_class, true};
+  } else {
+    MemoEntry& entry = memo_[mask];
+    if (!entry.settled) {
+      entry = {std::max(entry.value, cutoff), -1, false};
+    }
+  }
+  return best;
+}
+
+std::pair<int, double> EndgameSolver::best_guess() {
+  uint32_t all = num_sols_ == 32 ? 0xffffffffu : (1u << num_sols_) - 1;
+  std::vector<int> classes(class_guess_idxs_.size());
+  std::iota(classes.begin(), classes.end(), 0);
+  root_ = all;
+  root_best_class_ = -1;
+  aborted_ = false;
+  int total = solve(all, INT32_MAX, classes);
+  if (aborted_ && root_best_class_ >= 0) {
+    return std::make_pair(class_guess_idxs_.at(root_best_class_), (double)root_best_total_ / num_sols_);
+  }
+  if (aborted_) {
+    // nothing finished; fall back to the highest entropy class.
+    int best_class = 0;
+    double best_entropy = -1.0;
+    for (int c = 0; c < class_guess_idxs_.size(); ++c) {
+      const uint8_t* row = patterns_.data() + (size_t)c * num_sols_;
+      int counts[243] = {0};
+      for (int s = 0; s < num_sols_; ++s) {
+	++counts[row[s]];
+      }
+      double entropy = 0.0;
+      for (int count : counts) {
+	if (count > 0) {
+	  entropy -= (double)count / num_sols_ * log2((double)count / num_sols_);
+	}
+      }
+      if (entropy > best_entropy) {
+	best_class = c;
+	best_entropy = entropy;
+      }
+    }
+    return std::make_pair(class_guess_idxs_.at(best_class), 0.0);
+  }
+  int c = memo_.count(all) ? memo_.at(all).guess_class : candidate_class_.at(0);
+  if (c < 0) {
+    c = 0;
+  }
+  return std::make_pair(class_guess_idxs_.at(c), (double)total / num_sols_);
+}
+
+std::pair<std::string, double> choose_guess(const std::vector<std::string>& guess_words, const std::vector<int>& constrained_guess_idxs, const std::vector<std::string>& sol_words, const std::vector<int>& constrained_sol_idxs, bool use_cache, bool exact) {
+  if (constrained_sol_idxs.size() > kEndgameThreshold) {
+    if (use_cache) {
+      return get_best_word(guess_words, constrained_guess_idxs, sol_words, constrained_sol_idxs, use_cache);
+    }
+    return get_best_word_prefiltered(guess_words, constrained_guess_idxs, sol_words, constrained_sol_idxs, kPrefilterShortlist, exact);
+  }
+  EndgameSolver solver(guess_words, constrained_guess_idxs, sol_words, constrained_sol_idxs);
+  const std::string& guess = guess_words.at(solver.best_guess().first);
+  return std::make_pair(guess, calc_entropy_for_word(guess, sol_words, constrained_sol_idxs));
+}
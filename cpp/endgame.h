@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// at this many remaining solutions or fewer choose_guess stops using entropy and uses
+// EndgameSolver. bench_endgame puts the solver at 10-25 ms for 20-32 words, about 0.7 ms a word,
+// and it saves about 0.2 guesses a word over entropy at every size, so this is the solver's own
+// limit.
+constexpr int kEndgameThreshold = 32;
+
+// guess classes tried at each endgame node: the best this many by entropy, plus the candidates
+// themselves, which can end the game right away.
+constexpr int kEndgameShortlist = 16;
+
+// at this many words or fewer a node tries every class, so below it the solver is exact.
+constexpr int kEndgameExactSize = 8;
+
+struct SearchLimits;
+
+// branch and bound solver for small candidate sets (at most 32). finds the guess that minimizes
+// the expected number of guesses to finish when every node bigger than kEndgameExactSize only
+// tries its top shortlist splits, so it's a heuristic above that size (shortlist 0 tries them all,
+// which is exact but slow). subsets of the candidates are bitmasks, which is also what the memo
+// is keyed on. with limits the search gives up once they expire (see complete()).
+class EndgameSolver {
+ public:
+  EndgameSolver(const std::vector<std::string>& guess_words, const std::vector<int>& constrained_guess_idxs, const std::vector<std::string>& sol_words, const std::vector<int>& constrained_sol_idxs, const SearchLimits* limits = nullptr, int shortlist = kEndgameShortlist);
+
+  // best guess (an index into guess_words) and the expected number of guesses including it.
+  // if the limits ran out first, the best first guess whose subtree was finished (its expected
+  // guesses are an upper bound), or failing that the highest entropy one, with 0 expected guesses.
+  std::pair<int, double> best_guess();
+
+  // false if the last best_guess() was cut short by the limits.
+  bool complete() const { return !aborted_; }
+
+ private:
+  // fewest total guesses the search finds, summed over every word in mask, or something >= cutoff
+  // if that is not below cutoff. classes are the guess classes worth trying over a superset of mask.
+  int solve(uint32_t mask, int cutoff, const std::vector<int>& classes);
+
+  struct MemoEntry {
+    int value;
+    // the class to guess; -1 unless settled.
+    int guess_class;
+    // if false, value is only a lower bound (the search below it was cut off).
+    bool settled;
+  };
+
+  int num_sols_;
+  // one entry per distinct way of splitting the candidates. patterns_[g * num_sols_ + s].
+  std::vector<int> class_guess_idxs_;
+  std::vector<uint8_t> patterns_;
+  // for each candidate, the class of guessing it, or -1 if it isn't a valid guess.
+  std::vector<int> candidate_class_;
+  std::unordered_map<uint32_t, MemoEntry> memo_;
+  const SearchLimits* limits_;
+  int shortlist_;
+  bool aborted_ = false;
+  // the whole candidate set, and the best guess class for it finished so far.
+  uint32_t root_ = 0;
+  int root_best_class_ = -1;
+  int root_best_total_ = 0;
+};
+
+// get_best_word, except that with kEndgameThreshold or fewer solutions left the guess comes
+// from EndgameSolver. returns the guess and its entropy, like get_best_word. without the cache
+// the entropy search is get_best_word_prefiltered; exact = false skips its proof and takes the
+// best of the shortlist.
+std::pair<std::string, double> choose_guess(const std::vector<std::string>& guess_words, const std::vector<int>& constrained_guess_idxs, const std::vector<std::string>& sol_words, const std::vector<int>& constrained_sol_idxs, bool use_cache, bool exact = true);
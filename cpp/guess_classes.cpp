@@ -0,0 +1,82 @@
+#include "guess_classes.h"
+#include "utils.h"
+
+namespace {
+
+// group guesses (ascending) by their pattern against every constrained solution. a guess that
+// stands for several from an earlier grouping brings its weight along.
+template <typename PatternOf>
+GuessClasses group_by_signature(const std::vector<int>& guess_idxs, const std::vector<int>& weights, const std::vector<int>& constrained_sol_idxs, PatternOf pattern_of) {
+  GuessClasses classes;
+  std::unordered_map<std::string, int> class_of_signature;
+  class_of_signature.reserve(guess_idxs.size());
+  std::string signature(constrained_sol_idxs.size(), '\0');
+  for (int i = 0; i < guess_idxs.size(); ++i) {
+    int g = guess_idxs[i];
+    for (int s = 0; s < constrained_sol_idxs.size(); ++s) {
+      signature[s] = (char)pattern_of(g, constrained_sol_idxs[s]);
+    }
+    auto [it, inserted] = class_of_signature.emplace(signature, classes.representatives.size());
+    if (inserted) {
+      classes.representatives.push_back(g);
+      classes.sizes.push_back(weights[i]);
+    } else {
+      classes.sizes[it->second] += weights[i];
+    }
+  }
+  return classes;
+}
+
+std::vector<int> sorted(std::vector<int> idxs) {
+  std::sort(idxs.begin(), idxs.end());
+  return idxs;
+}
+
+}  // namespace
+
+GuessClasses singleton_guess_classes(const std::vector<int>& guess_idxs) {
+  return {sorted(guess_idxs), std::vector<int>(guess_idxs.size(), 1)};
+}
+
+GuessClasses classify_guesses(const std::vector<std::string>& guess_words, const std::vector<int>& guess_idxs, const std::vector<std::string>& sol_words, const std::vector<int>& constrained_sol_idxs) {
+  return refine_guess_classes(singleton_guess_classes(guess_idxs), guess_words, sol_words, constrained_sol_idxs);
+}
+
+GuessClasses classify_guesses(const uint8_t* patterns, int num_sols, const std::vector<int>& guess_idxs, const std::vector<int>& constrained_sol_idxs) {
+  return refine_guess_classes(singleton_guess_classes(guess_idxs), patterns, num_sols, constrained_sol_idxs);
+}
+
+GuessClasses refine_guess_classes(const GuessClasses& parent, const std::vector<std::string>& guess_words, const std::vector<std::string>& sol_words, const std::vector<int>& constrained_sol_idxs) {
+  return group_by_signature(parent.representatives, parent.sizes, constrained_sol_idxs, [&](int g, int s) {
+    return calc_pattern(guess_words[g], sol_words[s]); });
+}
+
+GuessClasses refine_guess_classes(const GuessClasses& parent, const uint8_t* patterns, int num_sols, const std::vector<int>& constrained_sol_idxs) {
+  return group_by_signature(parent.representatives, parent.sizes, constrained_sol_idxs, [&](int g, int s) {
+    return patterns[(size_t)g * num_sols + s]; });
+}
+
+std::string GuessClassCache::key(const std::vector<int>& constrained_sol_idxs) {
+  return std::string((const char*)constrained_sol_idxs.data(), constrained_sol_idxs.size() * sizeof(int));
+}
+
+std::shared_ptr<const GuessClasses> GuessClassCache::find(const std::string& key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = classes_.find(key);
+  return it == classes_.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<const GuessClasses> GuessClassCache::insert(const std::string& key, GuessClasses classes) {
+  auto entry = std::make_shared<const GuessClasses>(std::move(classes));
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (num_representatives_ + entry->representatives.size() > max_representatives_) {
+    // callers still holding an entry keep it alive through their shared_ptr.
+    classes_.clear();
+    num_representatives_ = 0;
+  }
+  auto [it, inserted] = classes_.emplace(key, entry);
+  if (inserted) {
+    num_representatives_ += entry->representatives.size();
+  }
+  return it->second;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// guesses that put every remaining solution in the same partition are interchangeable: same
+// entropy, same children, same everything. mid game most of the ~12k guesses collapse into a
+// few hundred such classes, so we only ever need to score one guess per class.
+//
+// a class over some solutions can only split further over a subset of them, so the classes of
+// a child node are found by comparing just the parent's representatives (refine_guess_classes)
+// instead of every guess again. that is what makes classes pay off in tree searches
+// (calculate_worst_case, solve_optimal). a single decision like get_best_word gains nothing:
+// classifying the guesses takes the same pass over them as scoring them.
+struct GuessClasses {
+  // one guess per class, the lowest index (so also the alphabetically first word), ascending.
+  std::vector<int> representatives;
+  // how many guesses each representative stands for.
+  std::vector<int> sizes;
+};
+
+// every guess in its own class, e.g. for the root before anything is known.
+GuessClasses singleton_guess_classes(const std::vector<int>& guess_idxs);
+
+// group guess_idxs by the partition they make of the constrained solutions.
+GuessClasses classify_guesses(const std::vector<std::string>& guess_words, const std::vector<int>& guess_idxs, const std::vector<std::string>& sol_words, const std::vector<int>& constrained_sol_idxs);
+
+// same, reading the patterns from the pattern table (table[guess_idx * num_sols + sol_idx]).
+GuessClasses classify_guesses(const uint8_t* patterns, int num_sols, const std::vector<int>& guess_idxs, const std::vector<int>& constrained_sol_idxs);
+
+// classes over constrained_sol_idxs, given the classes over a superset of them.
+GuessClasses refine_guess_classes(const GuessClasses& parent, const std::vector<std::string>& guess_words, const std::vector<std::string>& sol_words, const std::vector<int>& constrained_sol_idxs);
+
+GuessClasses refine_guess_classes(const GuessClasses& parent, const uint8_t* patterns, int num_sols, const std::vector<int>& constrained_sol_idxs);
+
+// classes keyed by candidate set, for searches that reach the same set along different paths.
+// thread safe. in hard mode the allowed guesses are part of the key; callers append them.
+// once the cached classes hold more than max_representatives guesses (16M, about 128 MB, by
+// default) the cache starts over, which only costs recomputing them.
+class GuessClassCache {
+ public:
+  explicit GuessClassCache(size_t max_representatives = size_t(1) << 24) : max_representatives_(max_representatives) {}
+
+  static std::string key(const std::vector<int>& constrained_sol_idxs);
+
+  // nullptr if not cached yet.
+  std::shared_ptr<const GuessClasses> find(const std::string& key);
+
+  // returns what ends up cached, which is the existing entry if another thread got there first.
+  std::shared_ptr<const GuessClasses> insert(const std::string& key, GuessClasses classes);
+
+ private:
+  const size_t max_representatives_;
+  size_t num_representatives_ = 0;
+  std::mutex mutex_;
+  std::unordered_map<std::string, std::shared_ptr<const GuessClasses>> classes_;
+};
@@ -0,0 +1,38 @@
+#include "hard_mode.h"
+#include "utils.h"
+
+#include <numeric>
+
+HardModeGuesses::HardModeGuesses(const std::vector<std::string>& guess_words)
+  : guess_words_(&guess_words), allowed_(guess_words.size()) {
+  std::iota(std::begin(allowed_), std::end(allowed_), 0);
+}
+
+HardModeGuesses::HardModeGuesses(const std::vector<std::string>& guess_words, std::vector<int> allowed)
+  : guess_words_(&guess_words), allowed_(std::move(allowed)) {}
+
+void HardModeGuesses::apply_feedback(const std::string& guess, int pattern) {
+  allowed_.erase(std::remove_if(allowed_.begin(), allowed_.end(), [&](int idx) {
+    return calc_pattern_any_length(guess, guess_words_->at(idx)) != pattern; }), allowed_.end());
+}
+
+HardModeGuesses HardModeGuesses::after_feedback(const std::string& guess, int pattern) const {
+  HardModeGuesses out = *this;
+  out.apply_feedback(guess, pattern);
+  return out;
+}
+
+std::vector<HardModeGuesses> HardModeGuesses::split(const std::string& guess, const std::vector<bool>& wanted) const {
+  std::vector<std::vector<int>> parts(pow3(guess.size()));
+  for (int idx : allowed_) {
+    int pattern = calc_pattern_any_length(guess, guess_words_->at(idx));
+    if (wanted.at(pattern)) {
+      parts[pattern].push_back(idx);
+    }
+  }
+  std::vector<HardModeGuesses> out;
+  for (auto& part : parts) {
+    out.push_back(HardModeGuesses(*guess_words_, std::move(part)));
+  }
+  return out;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// the guesses still allowed in hard mode. every guess has to be consistent with all the
+// feedback seen so far: guess h survives feedback `pattern` for `guess` iff
+// calc_pattern(guess, h) == pattern (for any word length), i.e. h would have been a possible answer. applying
+// feedback only re-checks the guesses that survived the previous feedback.
+class HardModeGuesses {
+ public:
+  // every guess word allowed.
+  explicit HardModeGuesses(const std::vector<std::string>& guess_words);
+
+  void apply_feedback(const std::string& guess, int pattern);
+
+  HardModeGuesses after_feedback(const std::string& guess, int pattern) const;
+
+  // the allowed set after each of the 3^N possible feedbacks for guess, in one pass over the
+  // allowed guesses. only the patterns with wanted[pattern] set are filled in.
+  std::vector<HardModeGuesses> split(const std::string& guess, const std::vector<bool>& wanted) const;
+
+  // indices into guess_words.
+  const std::vector<int>& allowed() const { return allowed_; }
+
+ private:
+  HardModeGuesses(const std::vector<std::string>& guess_words, std::vector<int> allowed);
+
+  const std::vector<std::string>* guess_words_;
+  std::vector<int> allowed_;
+};
@@ -0,0 +1,229 @@
+#include "utils.h"
+#include "task_scheduler.h"
+#include "wordle_core.h"
+
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// solver for the multi-board variants (dordle, quordle, octordle, ...): every guess is played
+// on all boards at once, each board has its own answer, and a board drops out once solved.
+
+constexpr int kMaxBoards = 32;
+
+struct Board {
+  Session session;
+  bool solved = false;
+};
+
+// scores one guess against every unsolved board. a single pass over the guess's row of the
+// pattern table (restricted to the union of the boards' candidates) fills one histogram per
+// board; each solution carries a bitmask of the boards it is still a candidate on.
+struct MultiBoardScorer {
+  const uint8_t* patterns;
+  int num_sols;
+  std::vector<int> board_sizes;
+  std::vector<int> union_sols;
+  std::vector<uint32_t> board_masks;
+  // once every unsolved board is down to this many candidates, stop counting bits and
+  // minimize the expected number of guesses still needed instead.
+  bool endgame;
+
+  MultiBoardScorer(const uint8_t* patterns, int num_sols, const std::vector<Board>& boards, int endgame_size)
+    : patterns(patterns), num_sols(num_sols), endgame(true) {
+    std::vector<uint32_t> mask_of(num_sols, 0);
+    for (int b = 0; b < boards.size(); ++b) {
+      const std::vector<int>& sols = boards.at(b).session.candidates();
+      board_sizes.push_back(boards.at(b).solved ? 0 : sols.size());
+      if (boards.at(b).solved) {
+	continue;
+      }
+      endgame = endgame && sols.size() <= endgame_size;
+      for (int s : sols) {
+	mask_of.at(s) |= 1u << b;
+      }
+    }
+    for (int s = 0; s < num_sols; ++s) {
+      if (mask_of.at(s)) {
+	union_sols.push_back(s);
+	board_masks.push_back(mask_of.at(s));
+      }
+    }
+  }
+
+  // higher is better. counts is scratch space for boards.size() * 243 ints.
+  double score(int guess, int* counts) const {
+    const uint8_t* row = patterns + (size_t)guess * num_sols;
+    std::fill(counts, counts + board_sizes.size() * 243, 0);
+    for (int i = 0; i < union_sols.size(); ++i) {
+      int p = row[union_sols[i]];
+      for (uint32_t m = board_masks[i]; m; m &= m - 1) {
+	counts[__builtin_ctz(m) * 243 + p]++;
+      }
+    }
+    double score = 0.0;
+    for (int b = 0; b < board_sizes.size(); ++b) {
+      int n = board_sizes.at(b);
+      if (n == 0) {
+	continue;
+      }
+      const int* c = counts + b * 243;
+      if (!endgame) {
+	// the boards are independent, so the joint information is the sum.
+	score += entropy_of_counts(c, n);
+	continue;
+      }
+      // joint expected guesses: the words in a bucket of size k need at least (2k - 1) / k
+      // more guesses on average (one of them guessed next, the rest one after); the all-green
+      // bucket needs none. summed over boards, since each board's answer has to be guessed.
+      for (int p = 1; p < 243; ++p) {
+	if (c[p] > 0) {
+	  score -= (2.0 * c[p] - 1.0) / n;
+	}
+      }
+    }
+    return score;
+  }
+};
+
+// best guess for all boards, scoring chunks of the guess list in parallel. ties go to the
+// lowest guess index so the result doesn't depend on the number of threads.
+std::pair<int, double> best_multi_board_guess(const MultiBoardScorer& scorer, int num_guesses, TaskScheduler& scheduler) {
+  const int chunk_size = 256;
+  std::mutex best_mutex;
+  std::pair<int, double> best = std::make_pair(-1, 0.0);
+  for (int start = 0; start < num_guesses; start += chunk_size) {
+    scheduler.spawn([&, start]() {
+      std::vector<int> counts(scorer.board_sizes.size() * 243);
+      std::pair<int, double> chunk_best = std::make_pair(-1, 0.0);
+      for (int g = start; g < std::min(num_guesses, start + chunk_size); ++g) {
+	double score = scorer.score(g, counts.data());
+	if (chunk_best.first < 0 || score > chunk_best.second) {
+	  chunk_best = std::make_pair(g, score);
+	}
+      }
+      std::lock_guard<std::mutex> lock(best_mutex);
+      if (best.first < 0 || chunk_best.second > best.second ||
+	  (chunk_best.second == best.second && chunk_best.first < best.first)) {
+	best = chunk_best;
+      }
+    });
+  }
+  scheduler.wait();
+  return best;
+}
+
+int main(int argc, char** argv) {
+  // usage: ./multi_board [--boards N] [--threads N] [--endgame-size N] [--answers w1,w2,...] [--table-dir DIR] [--word-files]
+  // with --answers the game plays itself against those answers (one per board); otherwise
+  // type the feedback (same formats as solve_wordle) for each unsolved board.
+  int num_boards = 4;
+  int num_threads = 0;
+  int endgame_size = 8;
+  std::vector<std::string> answers;
+  std::string table_dir;
+  bool boards_given = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--word-files") {
+      use_word_files();
+    } else if (arg == "--boards" && i + 1 < argc) {
+      num_boards = std::stoi(argv[++i]);
+      boards_given = true;
+    } else if (arg == "--threads" && i + 1 < argc) {
+      num_threads = std::stoi(argv[++i]);
+    } else if (arg == "--endgame-size" && i + 1 < argc) {
+      endgame_size = std::stoi(argv[++i]);
+    } else if (arg == "--table-dir" && i + 1 < argc) {
+      table_dir = argv[++i];
+    } else if (arg == "--answers" && i + 1 < argc) {
+      std::stringstream ss(argv[++i]);
+      std::string word;
+      while (std::getline(ss, word, ',')) {
+	answers.push_back(word);
+      }
+    }
+  }
+  // one board per answer, whichever order the flags come in.
+  if (!answers.empty()) {
+    if (boards_given && num_boards != answers.size()) {
+      std::cout << "--boards " << num_boards << " doesn't match the " << answers.size() << " words in --answers" << std::endl;
+      return 1;
+    }
+    num_boards = answers.size();
+  }
+  if (num_boards < 1 || num_boards > kMaxBoards) {
+    std::cout << "number of boards has to be between 1 and " << kMaxBoards << std::endl;
+    return 1;
+  }
+
+  auto dictionary = Dictionary::load({/*with_table=*/true, table_dir});
+  const auto& guess_words = dictionary->guess_words();
+  const auto& sol_words = dictionary->sol_words();
+
+  std::vector<int> answer_idxs;
+  for (const auto& word : answers) {
+    int idx = dictionary->find_sol(word);
+    if (idx < 0) {
+      std::cout << word << " is not in solutions.txt" << std::endl;
+      return 1;
+    }
+    answer_idxs.push_back(idx);
+  }
+
+  std::vector<Board> boards(num_boards, Board{Session(*dictionary, /*hard_mode=*/false)});
+
+  TaskScheduler scheduler(num_threads);
+  int turn = 0;
+  while (std::any_of(boards.begin(), boards.end(), [](const Board& b) { return !b.solved; })) {
+    turn++;
+    auto start = std::chrono::steady_clock::now();
+    MultiBoardScorer scorer(dictionary->patterns(), sol_words.size(), boards, endgame_size);
+    auto [guess, score] = best_multi_board_guess(scorer, guess_words.size(), scheduler);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "turn " << turn << ": let's guess " << guess_words.at(guess) << " (" << (scorer.endgame ? "expected guesses left " : "entropy ") << (scorer.endgame ? (score == 0 ? 0 : -score) : score) << ", took " << ms << " ms)" << std::endl;
+
+    for (int b = 0; b < num_boards; ++b) {
+      Board& board = boards.at(b);
+      if (board.solved) {
+	continue;
+      }
+      // the word actually played, which may not be the one we suggested.
+      int played = guess;
+      int pattern;
+      if (!answer_idxs.empty()) {
+	pattern = dictionary->pattern(played, answer_idxs.at(b));
+      } else {
+	std::cout << "board " << b + 1 << " guess and colours, or constraint string:" << std::endl;
+	std::string played_word;
+	if (!read_feedback(std::cin, &played_word, &pattern)) {
+	  return 0;
+	}
+	played = dictionary->find_guess(played_word);
+	if (played < 0) {
+	  std::cout << played_word << " is not a valid guess" << std::endl;
+	  return 1;
+	}
+	if (pattern < 0) {
+	  std::cout << "expected five of G/Y/B, or five letters each followed by 1, 2 or 3" << std::endl;
+	  return 1;
+	}
+      }
+      if (pattern == 0) {
+	board.solved = true;
+	std::cout << "  board " << b + 1 << " solved" << std::endl;
+	continue;
+      }
+      board.session.apply_feedback(played, pattern);
+      std::cout << "  board " << b + 1 << ": " << board.session.candidates().size() << " solutions left" << std::endl;
+      if (board.session.candidates().empty()) {
+	std::cout << "no words found matching all constraints on board " << b + 1 << std::endl;
+	return 1;
+      }
+    }
+  }
+  std::cout << "solved all " << num_boards << " boards in " << turn << " guesses" << std::endl;
+}
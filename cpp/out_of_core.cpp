@@ -0,0 +1,39 @@
+#include "out_of_core.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+std::unique_ptr<MappedFile> MappedFile::open_read_only(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  struct stat st;
+  void* mapping = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return nullptr;
+  }
+  // sweeps go front to back: read ahead aggressively, drop pages behind us first.
+  madvise(mapping, st.st_size, MADV_SEQUENTIAL);
+  return std::unique_ptr<MappedFile>(new MappedFile((const uint8_t*)mapping, st.st_size));
+}
+
+MappedFile::~MappedFile() {
+  munmap((void*)data_, size_);
+}
+
+void MappedFile::will_need(size_t offset, size_t len) const {
+  // madvise wants a page aligned start.
+  size_t start = offset / 4096 * 4096;
+  madvise((void*)(data_ + start), std::min(size_, offset + len) - start, MADV_WILLNEED);
+}
+
+std::string MappedFile::temp_path_for(const std::string& path) {
+  return path + ".tmp." + std::to_string(getpid());
+}
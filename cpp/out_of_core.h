@@ -0,0 +1,303 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "shared_table.h"
+#include "word_length.h"
+
+// out-of-core guess x solution pattern table, for word lists whose table doesn't fit in memory
+// (every 7- or 8-letter word as a possible answer is a few GB). the table is written to disk
+// once, as tiles of consecutive guess rows, and sweeps stream through the tiles of a memory
+// mapping: before working on a tile they ask the kernel to start reading the next few
+// (madvise WILLNEED), so the disk reads overlap with computing histograms.
+//
+// when patterns take two bytes each, a row rarely has more than 256 distinct ones (most of the
+// 3^N feedbacks never occur against a given guess), so such a row is stored as its own
+// dictionary of patterns followed by a byte per solution, and histograms are counted straight
+// from that encoding. rows with more distinct patterns are stored as they are.
+
+// a read-only memory mapping of a whole file.
+class MappedFile {
+ public:
+  // nullptr if the file can't be opened or mapped.
+  static std::unique_ptr<MappedFile> open_read_only(const std::string& path);
+  ~MappedFile();
+
+  const uint8_t* data() const { return data_; }
+  size_t size() const { return size_; }
+
+  // start reading [offset, offset + len) in the background.
+  void will_need(size_t offset, size_t len) const;
+
+  // a temporary file name next to path that no other process will pick, for writing a file
+  // that is then renamed into place.
+  static std::string temp_path_for(const std::string& path);
+
+ private:
+  MappedFile(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+  const uint8_t* data_;
+  size_t size_;
+};
+
+// 3: repeated letters score like the game (see calc_pattern_n).
+constexpr uint32_t kOutOfCoreVersion = 3;
+
+struct OutOfCoreHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t word_length;
+  uint64_t num_guesses;
+  uint64_t num_sols;
+  uint64_t words_hash;
+  uint32_t tile_guesses;
+  uint32_t num_tiles;
+};
+
+// a tile starts with an OutOfCoreRow for each of its guesses, followed by the rows.
+struct OutOfCoreTile {
+  // page aligned.
+  uint64_t offset;
+  uint64_t bytes;
+};
+
+struct OutOfCoreRow {
+  // from the start of the tile.
+  uint32_t offset;
+  // 0 if the patterns are stored as they are, else the number of dictionary entries in front of
+  // the codes.
+  uint32_t dict_size;
+};
+
+template <int N>
+class OutOfCorePatternTable {
+ public:
+  using pattern_t = typename WordTraits<N>::pattern_t;
+  static constexpr int P = WordTraits<N>::kNumPatterns;
+  static constexpr size_t kPageSize = 4096;
+
+  // the table for these word lists at path, written there first if it's missing or was built
+  // from other lists. read_ahead is how many tiles to request ahead of the one being swept.
+  static std::unique_ptr<OutOfCorePatternTable> open_or_build(const std::string& path, const std::vector<std::string>& guess_words, const std::vector<std::string>& sol_words, int tile_guesses = 256, int read_ahead = 2) {
+    OutOfCoreHeader expected = {};
+    memcpy(expected.magic, "WORDLEOC", 8);
+    expected.version = kOutOfCoreVersion;
+    expected.word_length = N;
+    expected.num_guesses = guess_words.size();
+    expected.num_sols = sol_words.size();
+    expected.words_hash = hash_word_lists(guess_words, sol_words);
+    expected.tile_guesses = tile_guesses;
+    expected.num_tiles = (guess_words.size() + tile_guesses - 1) / tile_guesses;
+    std::unique_ptr<OutOfCorePatternTable> table(new OutOfCorePatternTable(read_ahead));
+    if (table->load(path, expected)) {
+      return table;
+    }
+    if (!write(path, expected, guess_words, sol_words) || !table->load(path, expected)) {
+      return nullptr;
+    }
+    return table;
+  }
+
+  int num_guesses() const { return header_.num_guesses; }
+  int num_sols() const { return header_.num_sols; }
+
+  // bytes on disk for the patterns, and what they'd take uncompressed.
+  size_t stored_bytes() const {
+    size_t bytes = 0;
+    for (int t = 0; t < header_.num_tiles; ++t) {
+      bytes += tiles_[t].bytes;
+    }
+    return bytes;
+  }
+  size_t raw_bytes() const { return header_.num_guesses * header_.num_sols * sizeof(pattern_t); }
+
+  int pattern(int guess, int sol) const {
+    const uint8_t* base = file_->data() + tiles_[guess / header_.tile_guesses].offset;
+    const OutOfCoreRow& row = ((const OutOfCoreRow*)base)[guess % header_.tile_guesses];
+    const pattern_t* dict = (const pattern_t*)(base + row.offset);
+    if (row.dict_size) {
+      return dict[((const uint8_t*)(dict + row.dict_size))[sol]];
+    }
+    return dict[sol];
+  }
+
+  // calls f(guess idx, counts) for every guess in constrained_guess_idxs, which has to be
+  // ascending, with its histogram over constrained_sol_idxs (3^N ints). tiles with none of the
+  // guesses are skipped.
+  template <typename F>
+  void for_each_histogram(const std::vector<int>& constrained_guess_idxs, const std::vector<int>& constrained_sol_idxs, F&& f) const {
+    std::vector<int> counts(P);
+    const int tile_guesses = header_.tile_guesses;
+    size_t i = 0;
+    while (i < constrained_guess_idxs.size()) {
+      const int t = constrained_guess_idxs[i] / tile_guesses;
+      for (int k = 1; k <= read_ahead_ && t + k < header_.num_tiles; ++k) {
+	file_->will_need(tiles_[t + k].offset, tiles_[t + k].bytes);
+      }
+      const OutOfCoreTile& tile = tiles_[t];
+      const uint8_t* base = file_->data() + tile.offset;
+      const OutOfCoreRow* rows = (const OutOfCoreRow*)base;
+      for (; i < constrained_guess_idxs.size() && constrained_guess_idxs[i] / tile_guesses == t; ++i) {
+	const int g = constrained_guess_idxs[i];
+	const OutOfCoreRow& row = rows[g - t * tile_guesses];
+	const pattern_t* dict = (const pattern_t*)(base + row.offset);
+	std::fill(counts.begin(), counts.end(), 0);
+	if (row.dict_size) {
+	  // count dictionary codes first, then map the (few) used codes to patterns.
+	  int code_counts[256] = {};
+	  const uint8_t* codes = (const uint8_t*)(dict + row.dict_size);
+	  for (const auto idx : constrained_sol_idxs) {
+	    code_counts[codes[idx]]++;
+	  }
+	  for (int c = 0; c < row.dict_size; ++c) {
+	    counts[dict[c]] += code_counts[c];
+	  }
+	} else {
+	  for (const auto idx : constrained_sol_idxs) {
+	    counts[dict[idx]]++;
+	  }
+	}
+	f(g, counts.data());
+      }
+    }
+  }
+
+ private:
+  explicit OutOfCorePatternTable(int read_ahead) : read_ahead_(read_ahead) {}
+
+  static size_t align(size_t offset) {
+    return (offset + kPageSize - 1) / kPageSize * kPageSize;
+  }
+
+  bool load(const std::string& path, const OutOfCoreHeader& expected) {
+    file_ = MappedFile::open_read_only(path);
+    if (!file_ || file_->size() < sizeof(OutOfCoreHeader) + expected.num_tiles * sizeof(OutOfCoreTile)) {
+      file_.reset();
+      return false;
+    }
+    memcpy(&header_, file_->data(), sizeof(header_));
+    if (memcmp(&header_, &expected, sizeof(header_)) != 0) {
+      file_.reset();
+      return false;
+    }
+    tiles_ = (const OutOfCoreTile*)(file_->data() + sizeof(OutOfCoreHeader));
+    if (!tiles_in_bounds()) {
+      file_.reset();
+      return false;
+    }
+    return true;
+  }
+
+  // every tile, and every row in it, lies inside the file, so a truncated or corrupted file is
+  // rebuilt instead of read out of bounds. the patterns themselves aren't checked; that would
+  // mean reading the whole table.
+  bool tiles_in_bounds() const {
+    const size_t file_size = file_->size();
+    const size_t first = sizeof(OutOfCoreHeader) + header_.num_tiles * sizeof(OutOfCoreTile);
+    for (size_t t = 0; t < header_.num_tiles; ++t) {
+      const OutOfCoreTile& tile = tiles_[t];
+      if (tile.offset < first || tile.offset > file_size || tile.bytes > file_size - tile.offset) {
+	return false;
+      }
+      const size_t num_rows = std::min<size_t>(header_.tile_guesses, header_.num_guesses - t * header_.tile_guesses);
+      if (num_rows * sizeof(OutOfCoreRow) > tile.bytes) {
+	return false;
+      }
+      const OutOfCoreRow* rows = (const OutOfCoreRow*)(file_->data() + tile.offset);
+      for (size_t r = 0; r < num_rows; ++r) {
+	const size_t row_bytes = rows[r].dict_size ? rows[r].dict_size * sizeof(pattern_t) + header_.num_sols : header_.num_sols * sizeof(pattern_t);
+	if (rows[r].dict_size > 256 || rows[r].offset > tile.bytes || row_bytes > tile.bytes - rows[r].offset) {
+	  return false;
+	}
+      }
+    }
+    return true;
+  }
+
+  // writes the table tile by tile, so it never has to fit in memory, to a temporary file of
+  // this process's own that is renamed to path once complete. two processes building the same
+  // table each rename a whole file, and the last one wins.
+  static bool write(const std::string& path, const OutOfCoreHeader& header, const std::vector<std::string>& guess_words, const std::vector<std::string>& sol_words) {
+    const std::string tmp_path = MappedFile::temp_path_for(path);
+    std::ofstream out(tmp_path, std::ios::binary | std::ios::trunc);
+    if (!out.good()) {
+      return false;
+    }
+    std::vector<OutOfCoreTile> tiles(header.num_tiles);
+    size_t offset = align(sizeof(OutOfCoreHeader) + tiles.size() * sizeof(OutOfCoreTile));
+    const size_t num_sols = sol_words.size();
+    std::vector<pattern_t> patterns;
+    std::vector<uint8_t> encoded;
+    for (int t = 0; t < header.num_tiles; ++t) {
+      const size_t g0 = (size_t)t * header.tile_guesses;
+      const size_t g1 = std::min(guess_words.size(), g0 + header.tile_guesses);
+      patterns.resize((g1 - g0) * num_sols);
+      for (size_t g = g0; g < g1; ++g) {
+	for (size_t s = 0; s < num_sols; ++s) {
+	  patterns[(g - g0) * num_sols + s] = calc_pattern_n<N>(guess_words[g].data(), sol_words[s].data());
+	}
+      }
+      encode(patterns, num_sols, &tiles[t], &encoded);
+      tiles[t].offset = offset;
+      out.seekp(offset);
+      out.write((const char*)encoded.data(), encoded.size());
+      offset = align(offset + encoded.size());
+    }
+    out.seekp(0);
+    out.write((const char*)&header, sizeof(header));
+    out.write((const char*)tiles.data(), tiles.size() * sizeof(OutOfCoreTile));
+    out.close();
+    if (!out.good() || rename(tmp_path.c_str(), path.c_str()) != 0) {
+      remove(tmp_path.c_str());
+      return false;
+    }
+    return true;
+  }
+
+  // rows of num_sols patterns, each behind its OutOfCoreRow.
+  static void encode(const std::vector<pattern_t>& patterns, size_t num_sols, OutOfCoreTile* tile, std::vector<uint8_t>* encoded) {
+    const size_t num_rows = patterns.size() / num_sols;
+    std::vector<OutOfCoreRow> rows(num_rows);
+    encoded->assign(num_rows * sizeof(OutOfCoreRow), 0);
+    std::vector<int> code(P);
+    std::vector<pattern_t> dict;
+    for (size_t r = 0; r < num_rows; ++r) {
+      const pattern_t* row = patterns.data() + r * num_sols;
+      dict.clear();
+      if (sizeof(pattern_t) > 1) {
+	std::fill(code.begin(), code.end(), -1);
+	for (size_t s = 0; s < num_sols && dict.size() <= 256; ++s) {
+	  if (code[row[s]] < 0) {
+	    code[row[s]] = dict.size();
+	    dict.push_back(row[s]);
+	  }
+	}
+      }
+      // keep everything two byte aligned.
+      encoded->resize((encoded->size() + 1) / 2 * 2);
+      rows[r].offset = encoded->size();
+      if (dict.empty() || dict.size() > 256) {
+	rows[r].dict_size = 0;
+	encoded->insert(encoded->end(), (const uint8_t*)row, (const uint8_t*)(row + num_sols));
+      } else {
+	rows[r].dict_size = dict.size();
+	encoded->insert(encoded->end(), (const uint8_t*)dict.data(), (const uint8_t*)(dict.data() + dict.size()));
+	for (size_t s = 0; s < num_sols; ++s) {
+	  encoded->push_back(code[row[s]]);
+	}
+      }
+    }
+    memcpy(encoded->data(), rows.data(), rows.size() * sizeof(OutOfCoreRow));
+    tile->bytes = encoded->size();
+  }
+
+  int read_ahead_;
+  std::unique_ptr<MappedFile> file_;
+  OutOfCoreHeader header_;
+  const OutOfCoreTile* tiles_ = nullptr;
+};
@@ -14,7 +14,7 @@ std::map<std::string, double> load_checkpoint() {
   std::map<std::string, double> entrop_dict;
   while (std::getline(in, str)) {
     int comma_pos = str.find(',');
-    entrop_dict[str.substr(0,5)] = std::stod(str.substr(6));
+    entrop_dict[str.substr(0, comma_pos)] = std::stod(str.substr(comma_pos + 1));
   }
   in.close();
   return entrop_dict;
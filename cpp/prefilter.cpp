@@ -0,0 +1,148 @@
+#include "prefilter.h"
+#include "utils.h"
+
+LetterFrequencies count_letter_frequencies(const std::vector<std::string>& sol_words, const std::vector<int>& constrained_sol_idxs) {
+  LetterFrequencies freq;
+  freq.num_sols = constrained_sol_idxs.size();
+  for (int idx : constrained_sol_idxs) {
+    const std::string& word = sol_words[idx];
+    int copies[26] = {};
+    for (int i = 0; i < word.size(); ++i) {
+      freq.at_pos[i][word[i] - 'a']++;
+      // the k-th copy of a letter puts the word in with_copies[k].
+      freq.with_copies[++copies[word[i] - 'a']][word[i] - 'a']++;
+    }
+  }
+  return freq;
+}
+
+PositionEntropies position_entropies(const LetterFrequencies& freq) {
+  PositionEntropies ent;
+  int n = freq.num_sols;
+  for (int i = 0; i < kMaxWordLength; ++i) {
+    for (int c = 0; c < 26; ++c) {
+      // green, yellow, grey.
+      int counts[3] = {freq.at_pos[i][c], freq.with_copies[1][c] - freq.at_pos[i][c], n - freq.with_copies[1][c]};
+      ent.h[i][c] = n > 0 ? entropy_of_counts(counts, n, 3) : 0.0;
+      int greens[2] = {freq.at_pos[i][c], n - freq.at_pos[i][c]};
+      ent.green[i][c] = n > 0 ? entropy_of_counts(greens, n, 2) : 0.0;
+    }
+  }
+  for (int m = 2; m <= kMaxWordLength; ++m) {
+    for (int c = 0; c < 26; ++c) {
+      // counts[k]: solutions with exactly k copies, or at least m for k = m.
+      int counts[kMaxWordLength + 1];
+      for (int k = 0; k < m; ++k) {
+	counts[k] = (k == 0 ? n : freq.with_copies[k][c]) - freq.with_copies[k + 1][c];
+      }
+      counts[m] = freq.with_copies[m][c];
+      ent.copies[m][c] = n > 0 ? entropy_of_counts(counts, n, m + 1) : 0.0;
+    }
+  }
+  ent.max_entropy = n > 0 ? log2(n) : 0.0;
+  return ent;
+}
+
+double entropy_upper_bound(const PositionEntropies& ent, const std::string& guess) {
+  int copies[26] = {};
+  for (char c : guess) {
+    copies[c - 'a']++;
+  }
+  double bound = 0.0;
+  for (int i = 0; i < guess.size(); ++i) {
+    const int c = guess[i] - 'a';
+    bound += copies[c] == 1 ? ent.h[i][c] : ent.green[i][c];
+  }
+  for (int c = 0; c < 26; ++c) {
+    bound += copies[c] > 1 ? ent.copies[copies[c]][c] : 0.0;
+  }
+  return std::min(bound, ent.max_entropy);
+}
+
+namespace {
+
+// guesses ranked by their upper bound, highest first, ties to the lowest index.
+std::vector<std::pair<double, int>> rank_by_bound(const std::vector<std::string>& guess_words, const std::vector<int>& constrained_guess_idxs, const std::vector<std::string>& sol_words, const std::vector<int>& constrained_sol_idxs) {
+  PositionEntropies ent = position_entropies(count_letter_frequencies(sol_words, constrained_sol_idxs));
+  std::vector<std::pair<double, int>> ranked;
+  ranked.reserve(constrained_guess_idxs.size());
+  for (int g : constrained_guess_idxs) {
+    ranked.push_back(std::make_pair(entropy_upper_bound(ent, guess_words[g]), g));
+  }
+  std::sort(ranked.begin(), ranked.end(), [](const std::pair<double, int>& a, const std::pair<double, int>& b) {
+    return a.first != b.first ? a.first > b.first : a.second < b.second; });
+  return ranked;
+}
+
+}  // namespace
+
+std::pair<std::string, double> get_best_word_prefiltered(const std::vector<std::string>& guess_words, const std::vector<int>& constrained_guess_idxs, const std::vector<std::string>& sol_words, const std::vector<int>& constrained_sol_idxs, int shortlist_size, bool exact, int* num_scored) {
+  std::vector<std::pair<double, int>> ranked = rank_by_bound(guess_words, constrained_guess_idxs, sol_words, constrained_sol_idxs);
+
+  int best = -1;
+  double best_ent = -1.0;
+  int scored = 0;
+  int limit = std::min<int>(std::max(shortlist_size, 1), ranked.size());
+  while (true) {
+    for (; scored < limit; ++scored) {
+      int g = ranked[scored].second;
+      double e = calc_entropy_for_word(guess_words[g], sol_words, constrained_sol_idxs);
+      // ties go to the lowest index, like get_best_word.
+      if (e > best_ent || (e == best_ent && g < best)) {
+	best = g;
+	best_ent = e;
+      }
+    }
+    // the bound and the exact entropy sum in different orders, hence the slack.
+    if (!exact || scored == ranked.size() || ranked[scored].first + 1e-9 < best_ent) {
+      break;
+    }
+    limit = std::min<int>(2 * limit, ranked.size());
+  }
+  if (num_scored) {
+    *num_scored = scored;
+  }
+  return std::make_pair(guess_words.at(best), best_ent);
+}
+
+AnytimeResult get_best_word_anytime(const std::vector<std::string>& guess_words, const std::vector<int>& constrained_guess_idxs, const std::vector<std::string>& sol_words, const std::vector<int>& constrained_sol_idxs, const SearchLimits& limits, TaskScheduler* scheduler) {
+  std::vector<std::pair<double, int>> ranked = rank_by_bound(guess_words, constrained_guess_idxs, sol_words, constrained_sol_idxs);
+  const int block_size = kAnytimeBlockSize * (scheduler ? scheduler->num_threads() : 1);
+  std::vector<double> entropies(ranked.size());
+  AnytimeResult result;
+  while (result.num_evaluated < ranked.size()) {
+    const int start = result.num_evaluated;
+    const int end = std::min<int>(start + block_size, ranked.size());
+    auto score = [&](int from, int to) {
+      for (int i = from; i < to; ++i) {
+	entropies[i] = calc_entropy_for_word(guess_words[ranked[i].second], sol_words, constrained_sol_idxs);
+      }
+    };
+    if (scheduler) {
+      for (int from = start; from < end; from += kAnytimeBlockSize) {
+	scheduler->spawn([&score, from, end]() { score(from, std::min(end, from + kAnytimeBlockSize)); });
+      }
+      scheduler->wait();
+    } else {
+      score(start, end);
+    }
+    // merged in rank order, so the threads don't change the answer.
+    for (int i = start; i < end; ++i) {
+      const int g = ranked[i].second;
+      if (result.guess < 0 || entropies[i] > result.entropy || (entropies[i] == result.entropy && g < result.guess)) {
+	result.guess = g;
+	result.entropy = entropies[i];
+      }
+    }
+    result.num_evaluated = end;
+    // the same slack as get_best_word_prefiltered.
+    if (end == ranked.size() || ranked[end].first + 1e-9 < result.entropy) {
+      result.proven = true;
+      break;
+    }
+    if (limits.expired()) {
+      break;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "task_scheduler.h"
+#include "word_length.h"
+
+// two-phase best guess: rank every guess by a cheap score built from per-position letter
+// frequencies over the remaining solutions, then compute the exact entropy of the top few.
+//
+// the cheap score is also an upper bound on the entropy. the pattern is fixed by which positions
+// are green and, for every letter of the guess, how many copies the solution has up to as many
+// as the guess has (the yellows are whatever that leaves over the greens). for a letter the
+// guess has once that's whether the solution has it there, elsewhere or not at all, whose
+// distribution the per-position frequencies give exactly; a repeated letter contributes each of
+// its positions' green or not plus its capped copy count. the entropy of the whole pattern is at
+// most the sum of those parts' entropies, so once the best exact entropy beats the bound of
+// every guess left out, nothing left out can win.
+
+// default number of guesses scored exactly before checking the bound.
+constexpr int kPrefilterShortlist = 128;
+
+struct LetterFrequencies {
+  int num_sols = 0;
+  // solutions with letter c at position i.
+  int at_pos[kMaxWordLength][26] = {};
+  // solutions with at least k copies of letter c (k >= 1, so with_copies[1] is "anywhere").
+  int with_copies[kMaxWordLength + 1][26] = {};
+};
+
+LetterFrequencies count_letter_frequencies(const std::vector<std::string>& sol_words, const std::vector<int>& constrained_sol_idxs);
+
+// the entropies every guess's bound is summed from.
+struct PositionEntropies {
+  // green / yellow / grey at [position] for a [letter] the guess has once.
+  double h[kMaxWordLength][26];
+  // for a [letter] the guess repeats: green or not at each [position], and the number of copies
+  // in the solution capped at the [copies in the guess].
+  double green[kMaxWordLength][26];
+  double copies[kMaxWordLength + 1][26];
+  double max_entropy;
+};
+
+PositionEntropies position_entropies(const LetterFrequencies& freq);
+
+// upper bound on the entropy of guess over the solutions the frequencies were counted on.
+double entropy_upper_bound(const PositionEntropies& ent, const std::string& guess);
+
+// same result as get_best_word without the cache, but only the top shortlist_size guesses by
+// the cheap score are scored exactly. with exact set, the shortlist doubles until the bound
+// proves no excluded guess can beat (or tie with a lower index) the best one found, so the
+// answer is always the true max entropy guess. num_scored, if given, is how many were scored.
+std::pair<std::string, double> get_best_word_prefiltered(const std::vector<std::string>& guess_words, const std::vector<int>& constrained_guess_idxs, const std::vector<std::string>& sol_words, const std::vector<int>& constrained_sol_idxs, int shortlist_size, bool exact, int* num_scored = nullptr);
+
+// when an anytime search has to stop: at deadline, or once cancel (set from another thread)
+// is true. the defaults never stop it.
+struct SearchLimits {
+  std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+  const std::atomic<bool>* cancel = nullptr;
+
+  bool expired() const {
+    return (cancel && cancel->load(std::memory_order_relaxed)) || std::chrono::steady_clock::now() >= deadline;
+  }
+};
+
+struct AnytimeResult {
+  // index into guess_words of the best guess scored, and its entropy.
+  int guess = -1;
+  double entropy = 0.0;
+  int num_evaluated = 0;
+  // no guess left unscored can beat it (or tie with a lower index): it's the max entropy guess.
+  bool proven = false;
+};
+
+// guesses scored per block, per thread.
+constexpr int kAnytimeBlockSize = 64;
+
+// get_best_word_prefiltered against a clock: scores guesses in order of their entropy upper
+// bound a block at a time, and checks limits between blocks. stops when the bound proves the
+// best so far, when every guess has been scored or when limits expire, whichever comes first;
+// the first block is always scored so there's an answer. with a scheduler each block is split
+// across its threads, and the answer for a given number of scored guesses is the same.
+AnytimeResult get_best_word_anytime(const std::vector<std::string>& guess_words, const std::vector<int>& constrained_guess_idxs, const std::vector<std::string>& sol_words, const std::vector<int>& constrained_sol_idxs, const SearchLimits& limits, TaskScheduler* scheduler = nullptr);
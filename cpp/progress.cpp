@@ -0,0 +1,76 @@
+#include "progress.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+std::string status_path;
+
+}  // namespace
+
+void report_status_to(const std::string& path) {
+  status_path = path;
+}
+
+ProgressReporter::ProgressReporter(std::string label, int64_t total, std::chrono::milliseconds interval)
+  : label_(std::move(label)), total_(total), interval_(interval), start_(std::chrono::steady_clock::now()) {
+  thread_ = std::thread([this]() { run(); });
+}
+
+ProgressReporter::~ProgressReporter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  stop_cv_.notify_one();
+  thread_.join();
+  report(/*finished=*/true);
+}
+
+void ProgressReporter::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!stop_cv_.wait_for(lock, interval_, [this]() { return stop_; })) {
+    report(/*finished=*/false);
+    printed_ = true;
+  }
+}
+
+void ProgressReporter::report(bool finished) {
+  const int64_t done = done_.load(std::memory_order_relaxed);
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+  const double rate = elapsed > 0.0 ? done / elapsed : 0.0;
+  const double percent = total_ > 0 ? 100.0 * done / total_ : 100.0;
+  // -1 until there's a rate to go by.
+  const double eta = rate > 0.0 ? std::max<int64_t>(total_ - done, 0) / rate : -1.0;
+  if (!finished || printed_) {
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(1) << "[" << label_ << "] " << done << "/" << total_ << " (" << percent << "%), " << rate << "/s, ";
+    if (finished) {
+      line << "took " << elapsed << " s";
+    } else if (eta >= 0.0) {
+      line << "eta " << eta << " s";
+    } else {
+      line << "eta unknown";
+    }
+    std::cout << line.str() << std::endl;
+  }
+  if (status_path.empty()) {
+    return;
+  }
+  std::ostringstream json;
+  json << std::fixed << std::setprecision(1) << "{\"label\": \"" << label_ << "\", \"done\": " << done << ", \"total\": " << total_
+       << ", \"percent\": " << percent << ", \"elapsed_s\": " << elapsed << ", \"rate_per_s\": " << rate
+       << ", \"eta_s\": " << (finished ? 0.0 : eta) << ", \"finished\": " << (finished ? "true" : "false") << "}\n";
+  const std::string tmp = status_path + ".tmp";
+  std::ofstream out(tmp);
+  out << json.str();
+  out.close();
+  if (out.good()) {
+    std::rename(tmp.c_str(), status_path.c_str());
+  }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// progress of a long run. workers count finished units with add(), a single relaxed atomic add
+// that's safe from any thread (including scheduler tasks), and a reporter thread wakes up every
+// interval to print done/total, percent, rate and ETA. runs that finish within the first
+// interval print nothing, so quick cached runs look the same as before.
+//
+// with report_status_to set, the reporter also rewrites a status file every interval (and once
+// more when the run ends) with one line of JSON:
+//   {"label": "simulate", "done": 1200, "total": 2315, "percent": 51.8, "elapsed_s": 4.1,
+//    "rate_per_s": 292.7, "eta_s": 3.8, "finished": false}
+// written to a temporary file and renamed over it, so readers never see half a line.
+class ProgressReporter {
+ public:
+  ProgressReporter(std::string label, int64_t total, std::chrono::milliseconds interval = std::chrono::seconds(2));
+  // stops the reporter, with a last line if it printed any.
+  ~ProgressReporter();
+  ProgressReporter(const ProgressReporter&) = delete;
+  ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+  void add(int64_t n = 1) { done_.fetch_add(n, std::memory_order_relaxed); }
+
+ private:
+  void run();
+  void report(bool finished);
+
+  const std::string label_;
+  const int64_t total_;
+  const std::chrono::milliseconds interval_;
+  const std::chrono::steady_clock::time_point start_;
+  std::atomic<int64_t> done_{0};
+  bool printed_ = false;
+  bool stop_ = false;
+  std::mutex mutex_;
+  std::condition_variable stop_cv_;
+  std::thread thread_;
+};
+
+// every ProgressReporter from now on also writes its status to path.
+void report_status_to(const std::string& path);
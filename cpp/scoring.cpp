@@ -0,0 +1,31 @@
+#include "scoring.h"
+
+bool parse_scoring_policy(const std::string& name, ScoringPolicy* policy) {
+  const std::pair<const char*, ScoringPolicy> policies[] = {
+    {EntropyPolicy::name, ScoringPolicy::kEntropy},
+    {MinimaxPolicy::name, ScoringPolicy::kMinimax},
+    {ExpectedSizePolicy::name, ScoringPolicy::kExpectedSize},
+    {BucketCountPolicy::name, ScoringPolicy::kBucketCount},
+    {EntropyCandidateBonusPolicy::name, ScoringPolicy::kEntropyCandidateBonus},
+  };
+  for (const auto& [policy_name, p] : policies) {
+    if (name == policy_name) {
+      *policy = p;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string scoring_policy_names() {
+  return std::string(EntropyPolicy::name) + ", " + MinimaxPolicy::name + ", " + ExpectedSizePolicy::name + ", " + BucketCountPolicy::name + ", " + EntropyCandidateBonusPolicy::name;
+}
+
+std::pair<std::string, double> get_best_word_by_policy(ScoringPolicy policy, const std::vector<std::string>& guess_words, const std::vector<int>& constrained_guess_idxs, const std::vector<std::string>& sol_words, const std::vector<int>& constrained_sol_idxs) {
+  return dispatch_scoring_policy(policy, [&](auto p) {
+    return get_best_word_with<decltype(p)>(guess_words, constrained_guess_idxs, sol_words, constrained_sol_idxs); });
+}
+
+std::pair<int, double> best_guess_from_patterns_by_policy(ScoringPolicy policy, const std::vector<uint8_t>& patterns, int num_sols, const std::vector<int>& constrained_guess_idxs, const std::vector<int>& constrained_sol_idxs) {
+  return best_guess_from_patterns_by_policy_n<5>(policy, patterns, num_sols, constrained_guess_idxs, constrained_sol_idxs);
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include "utils.h"
+#include "tiled_sweep.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// scoring policies for picking a guess. each one reduces the pattern histogram of a guess
+// (counts[pattern] over the n remaining solutions) to a score, higher is better. the
+// best-guess search is a template on the policy, so the reduction is inlined into the loop.
+// counts[0] > 0 means the guess is itself one of the remaining solutions. P is the number of
+// patterns, 3^word length.
+
+// expected information in bits. the default, and what get_best_word uses.
+struct EntropyPolicy {
+  static constexpr const char* name = "entropy";
+  template <int P = 243>
+  static double score(const int* counts, int n) {
+    return entropy_of_counts(counts, n, P);
+  }
+};
+
+// smallest largest bucket.
+struct MinimaxPolicy {
+  static constexpr const char* name = "minimax";
+  template <int P = 243>
+  static double score(const int* counts, int /*n*/) {
+    int largest = 0;
+    for (int i = 0; i < P; ++i) {
+      largest = std::max(largest, counts[i]);
+    }
+    return -largest;
+  }
+};
+
+// expected number of solutions left afterwards, sum(c^2) / n.
+struct ExpectedSizePolicy {
+  static constexpr const char* name = "expected_size";
+  template <int P = 243>
+  static double score(const int* counts, int n) {
+    long long sum = 0;
+    for (int i = 0; i < P; ++i) {
+      sum += (long long)counts[i] * counts[i];
+    }
+    return -(double)sum / n;
+  }
+};
+
+// number of distinct feedbacks we could see.
+struct BucketCountPolicy {
+  static constexpr const char* name = "buckets";
+  template <int P = 243>
+  static double score(const int* counts, int /*n*/) {
+    int buckets = 0;
+    for (int i = 0; i < P; ++i) {
+      buckets += counts[i] > 0;
+    }
+    return buckets;
+  }
+};
+
+// entropy, plus a bonus for guesses that could be the answer: with probability 1/n we win
+// right away and save the log2(n) bits we would otherwise still need.
+struct EntropyCandidateBonusPolicy {
+  static constexpr const char* name = "entropy_bonus";
+  template <int P = 243>
+  static double score(const int* counts, int n) {
+    double ent = entropy_of_counts(counts, n, P);
+    return counts[0] > 0 ? ent + log2(n) / n : ent;
+  }
+};
+
+// best guess among constrained_guess_idxs and its score. ties go to the first guess.
+template <typename Policy>
+std::pair<std::string, double> get_best_word_with(const std::vector<std::string>& guess_words, const std::vector<int>& constrained_guess_idxs, const std::vector<std::string>& sol_words, const std::vector<int>& constrained_sol_idxs) {
+  int counts[243];
+  int best_idx = -1;
+  double best_score = 0.0;
+  for (const auto idx : constrained_guess_idxs) {
+    calc_pattern_counts(guess_words[idx], sol_words, constrained_sol_idxs, counts);
+    double score = Policy::score(counts, constrained_sol_idxs.size());
+    if (best_idx < 0 || score > best_score) {
+      best_idx = idx;
+      best_score = score;
+    }
+  }
+  return std::make_pair(guess_words.at(best_idx), best_score);
+}
+
+// same, with the patterns read from a guess x solution table of N-letter words (see
+// build_pattern_table_n). returns the guess idx.
+template <typename Policy, int N>
+std::pair<int, double> best_guess_from_patterns_n(const std::vector<typename WordTraits<N>::pattern_t>& patterns, int num_sols, const std::vector<int>& constrained_guess_idxs, const std::vector<int>& constrained_sol_idxs) {
+  constexpr int P = WordTraits<N>::kNumPatterns;
+  int counts[P];
+  int best_idx = -1;
+  double best_score = 0.0;
+  for (const auto idx : constrained_guess_idxs) {
+    calc_pattern_counts_n<N>(patterns.data() + (size_t)idx * num_sols, constrained_sol_idxs, counts);
+    double score = Policy::template score<P>(counts, constrained_sol_idxs.size());
+    if (best_idx < 0 || score > best_score) {
+      best_idx = idx;
+      best_score = score;
+    }
+  }
+  return std::make_pair(best_idx, best_score);
+}
+
+template <typename Policy>
+std::pair<int, double> best_guess_from_patterns(const std::vector<uint8_t>& patterns, int num_sols, const std::vector<int>& constrained_guess_idxs, const std::vector<int>& constrained_sol_idxs) {
+  return best_guess_from_patterns_n<Policy, 5>(patterns, num_sols, constrained_guess_idxs, constrained_sol_idxs);
+}
+
+// runtime choice of policy, for the command line. dispatches to the templates above.
+enum class ScoringPolicy {
+  kEntropy,
+  kMinimax,
+  kExpectedSize,
+  kBucketCount,
+  kEntropyCandidateBonus,
+};
+
+// calls f with a default-constructed policy of the selected type.
+template <typename F>
+auto dispatch_scoring_policy(ScoringPolicy policy, F&& f) {
+  switch (policy) {
+  case ScoringPolicy::kMinimax:
+    return f(MinimaxPolicy());
+  case ScoringPolicy::kExpectedSize:
+    return f(ExpectedSizePolicy());
+  case ScoringPolicy::kBucketCount:
+    return f(BucketCountPolicy());
+  case ScoringPolicy::kEntropyCandidateBonus:
+    return f(EntropyCandidateBonusPolicy());
+  case ScoringPolicy::kEntropy:
+  default:
+    return f(EntropyPolicy());
+  }
+}
+
+// false if name isn't one of the policies' names.
+bool parse_scoring_policy(const std::string& name, ScoringPolicy* policy);
+
+std::string scoring_policy_names();
+
+std::pair<std::string, double> get_best_word_by_policy(ScoringPolicy policy, const std::vector<std::string>& guess_words, const std::vector<int>& constrained_guess_idxs, const std::vector<std::string>& sol_words, const std::vector<int>& constrained_sol_idxs);
+
+std::pair<int, double> best_guess_from_patterns_by_policy(ScoringPolicy policy, const std::vector<uint8_t>& patterns, int num_sols, const std::vector<int>& constrained_guess_idxs, const std::vector<int>& constrained_sol_idxs);
+
+template <int N>
+std::pair<int, double> best_guess_from_patterns_by_policy_n(ScoringPolicy policy, const std::vector<typename WordTraits<N>::pattern_t>& patterns, int num_sols, const std::vector<int>& constrained_guess_idxs, const std::vector<int>& constrained_sol_idxs) {
+  return dispatch_scoring_policy(policy, [&](auto p) {
+    return best_guess_from_patterns_n<decltype(p), N>(patterns, num_sols, constrained_guess_idxs, constrained_sol_idxs); });
+}
+
+// same, on the tiled sweep (see tiled_sweep.h).
+template <int N>
+std::pair<int, double> best_guess_tiled_by_policy_n(ScoringPolicy policy, const TiledPatternTable<N>& table, const std::vector<int>& constrained_guess_idxs, const std::vector<int>& constrained_sol_idxs) {
+  return dispatch_scoring_policy(policy, [&](auto p) {
+    return best_guess_tiled_n<decltype(p), N>(table, constrained_guess_idxs, constrained_sol_idxs); });
+}
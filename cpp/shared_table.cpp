@@ -0,0 +1,188 @@
+#include "shared_table.h"
+#include "utils.h"
+
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char kMagic[8] = {'W', 'O', 'R', 'D', 'L', 'E', 'P', 'T'};
+// the patterns start on their own page after the header.
+constexpr size_t kDataOffset = 4096;
+// hugetlbfs files have to be whole huge pages; rounding to 2 MB costs nothing on tmpfs.
+constexpr size_t kFileAlignment = 2 << 20;
+
+size_t file_size_for(size_t table_bytes) {
+  return (kDataOffset + table_bytes + kFileAlignment - 1) / kFileAlignment * kFileAlignment;
+}
+
+// maps path read only if it holds a valid table matching expected; nullptr otherwise.
+void* attach(const std::string& path, const SharedTableHeader& expected, size_t* mapping_size) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+  size_t table_bytes = expected.num_guesses * expected.num_sols;
+  struct stat st;
+  void* mapping = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && st.st_size >= kDataOffset + table_bytes) {
+    mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    return nullptr;
+  }
+  const auto* header = (const SharedTableHeader*)mapping;
+  if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != expected.version ||
+      header->word_length != expected.word_length || header->num_guesses != expected.num_guesses ||
+      header->num_sols != expected.num_sols || header->words_hash != expected.words_hash ||
+      header->checksum != pattern_checksum((const uint8_t*)mapping + kDataOffset, table_bytes)) {
+    munmap(mapping, st.st_size);
+    return nullptr;
+  }
+  *mapping_size = st.st_size;
+  return mapping;
+}
+
+// builds the table into a temporary file and renames it to path. the caller holds the lock.
+bool publish(const std::string& path, SharedTableHeader header, const std::vector<std::string>& guess_words, const std::vector<std::string>& sol_words) {
+  std::string tmp_path = path + ".tmp." + std::to_string(getpid());
+  int fd = open(tmp_path.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+  if (fd < 0) {
+    return false;
+  }
+  size_t table_bytes = guess_words.size() * sol_words.size();
+  size_t size = file_size_for(table_bytes);
+  void* mapping = MAP_FAILED;
+  if (ftruncate(fd, size) == 0) {
+    mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    unlink(tmp_path.c_str());
+    return false;
+  }
+  uint8_t* table = (uint8_t*)mapping + kDataOffset;
+  for (size_t g = 0; g < guess_words.size(); ++g) {
+    for (size_t s = 0; s < sol_words.size(); ++s) {
+      table[g * sol_words.size() + s] = calc_pattern(guess_words[g], sol_words[s]);
+    }
+  }
+  header.checksum = pattern_checksum(table, table_bytes);
+  memcpy(mapping, &header, sizeof(header));
+  bool ok = msync(mapping, size, MS_SYNC) == 0;
+  munmap(mapping, size);
+  if (!ok || rename(tmp_path.c_str(), path.c_str()) != 0) {
+    unlink(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+uint64_t hash_word_lists(const std::vector<std::string>& guess_words, const std::vector<std::string>& sol_words) {
+  // fnv-1a over both lists, with a separator so moving a word between them changes the hash.
+  uint64_t h = 14695981039346656037ull;
+  for (const auto* words : {&guess_words, &sol_words}) {
+    for (const auto& word : *words) {
+      for (char c : word) {
+	h = (h ^ (uint8_t)c) * 1099511628211ull;
+      }
+      h = (h ^ '\n') * 1099511628211ull;
+    }
+    h = (h ^ 0xff) * 1099511628211ull;
+  }
+  return h;
+}
+
+uint64_t pattern_checksum(const uint8_t* patterns, size_t size) {
+  // fnv-1a style, a word at a time so checking 30 MB on attach stays in the milliseconds.
+  uint64_t h = 14695981039346656037ull ^ size;
+  size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+    uint64_t word;
+    memcpy(&word, patterns + i, 8);
+    h = (h ^ word) * 1099511628211ull;
+  }
+  for (; i < size; ++i) {
+    h = (h ^ patterns[i]) * 1099511628211ull;
+  }
+  return h;
+}
+
+PatternTable PatternTable::build(const std::vector<std::string>& guess_words, const std::vector<std::string>& sol_words) {
+  PatternTable table;
+  table.private_ = build_pattern_table(guess_words, sol_words);
+  table.data_ = table.private_.data();
+  return table;
+}
+
+PatternTable PatternTable::open_shared(const std::string& table_dir, const std::vector<std::string>& guess_words, const std::vector<std::string>& sol_words) {
+  SharedTableHeader header = {};
+  memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kSharedTableVersion;
+  header.word_length = 5;
+  header.num_guesses = guess_words.size();
+  header.num_sols = sol_words.size();
+  header.words_hash = hash_word_lists(guess_words, sol_words);
+  std::stringstream name;
+  name << table_dir << "/wordle_patterns_" << std::hex << header.words_hash << ".tbl";
+  std::string path = name.str();
+
+  PatternTable table;
+  table.mapping_ = attach(path, header, &table.mapping_size_);
+  if (!table.mapping_) {
+    // only one process builds; the rest block here and then find it published.
+    int lock_fd = open((path + ".lock").c_str(), O_CREAT | O_RDWR, 0644);
+    if (lock_fd >= 0 && flock(lock_fd, LOCK_EX) == 0) {
+      table.mapping_ = attach(path, header, &table.mapping_size_);
+      if (!table.mapping_ && publish(path, header, guess_words, sol_words)) {
+	std::cout << "published pattern table to " << path << std::endl;
+	table.mapping_ = attach(path, header, &table.mapping_size_);
+      }
+      flock(lock_fd, LOCK_UN);
+    }
+    if (lock_fd >= 0) {
+      close(lock_fd);
+    }
+  }
+  if (!table.mapping_) {
+    std::cout << "can't use a shared pattern table in " << table_dir << ", building a private one" << std::endl;
+    return build(guess_words, sol_words);
+  }
+  table.data_ = (const uint8_t*)table.mapping_ + kDataOffset;
+  return table;
+}
+
+PatternTable::PatternTable(PatternTable&& other) {
+  *this = std::move(other);
+}
+
+PatternTable& PatternTable::operator=(PatternTable&& other) {
+  if (this != &other) {
+    if (mapping_) {
+      munmap(mapping_, mapping_size_);
+    }
+    private_ = std::move(other.private_);
+    mapping_ = other.mapping_;
+    mapping_size_ = other.mapping_size_;
+    data_ = mapping_ ? other.data_ : private_.data();
+    other.mapping_ = nullptr;
+    other.data_ = nullptr;
+  }
+  return *this;
+}
+
+PatternTable::~PatternTable() {
+  if (mapping_) {
+    munmap(mapping_, mapping_size_);
+  }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// the 5-letter guess x solution pattern table, either built privately or shared between every
+// solver process on the host. the shared one lives in a file under table_dir, normally
+// /dev/shm (POSIX shared memory) or a hugetlbfs mount, and is mapped read only, so attaching
+// costs no copy and the processes share the same physical pages.
+//
+// the first process to need a table builds it: under an exclusive flock on a lock file next to
+// it, it writes the table to a temporary file and renames it into place, so other processes
+// either see no table (and wait for the lock) or the finished one. the header records the
+// format version, the dimensions, a hash of the word lists and a checksum of the patterns;
+// a table that doesn't match is rebuilt.
+
+// 2: repeated letters score like the game (see calc_pattern_n).
+constexpr uint32_t kSharedTableVersion = 2;
+
+struct SharedTableHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t word_length;
+  uint64_t num_guesses;
+  uint64_t num_sols;
+  // of the guess and solution lists the table was built from.
+  uint64_t words_hash;
+  // of the num_guesses * num_sols pattern bytes.
+  uint64_t checksum;
+};
+
+class PatternTable {
+ public:
+  // a private table, like build_pattern_table.
+  static PatternTable build(const std::vector<std::string>& guess_words, const std::vector<std::string>& sol_words);
+
+  // the shared table for these word lists in table_dir, built and published first if there
+  // isn't a valid one. falls back to a private table (with a message) if table_dir can't be used.
+  static PatternTable open_shared(const std::string& table_dir, const std::vector<std::string>& guess_words, const std::vector<std::string>& sol_words);
+
+  PatternTable(PatternTable&& other);
+  PatternTable& operator=(PatternTable&& other);
+  PatternTable(const PatternTable&) = delete;
+  PatternTable& operator=(const PatternTable&) = delete;
+  ~PatternTable();
+
+  // table[guess_idx * num_sols + sol_idx].
+  const uint8_t* data() const { return data_; }
+  bool is_shared() const { return mapping_ != nullptr; }
+
+ private:
+  PatternTable() = default;
+
+  std::vector<uint8_t> private_;
+  void* mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  const uint8_t* data_ = nullptr;
+};
+
+uint64_t hash_word_lists(const std::vector<std::string>& guess_words, const std::vector<std::string>& sol_words);
+
+uint64_t pattern_checksum(const uint8_t* patterns, size_t size);
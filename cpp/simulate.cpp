@@ -0,0 +1,253 @@
+#include "utils.h"
+#include "compressed_table.h"
+#include "hard_mode.h"
+#include "out_of_core.h"
+#include "progress.h"
+#include "scoring.h"
+#include "task_scheduler.h"
+
+#include <array>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// plays every solution word with the given scoring policy and reports how many guesses each
+// took. games that share a prefix of feedback make the same choices, so rather than playing
+// them one by one we walk the decision tree once, one task per node.
+
+constexpr int kMaxTrackedGuesses = 32;
+
+// only keep a solution-major copy of the pattern table (for sparse candidate sets) below this size.
+constexpr size_t kSolutionMajorBudgetBytes = 512 << 20;
+
+template <int N>
+struct Simulation {
+  static constexpr int P = WordTraits<N>::kNumPatterns;
+
+  const std::vector<std::string>& guess_list;
+  const std::vector<std::string>& solution_list;
+  // the pattern table: plain in memory, streamed from disk or compressed in memory (exactly one
+  // of them is set).
+  const TiledPatternTable<N>* table;
+  const OutOfCorePatternTable<N>* disk;
+  const CompressedPatternTable<N>* compressed;
+  ScoringPolicy policy;
+  bool hard_mode;
+  TaskScheduler& scheduler;
+  // counts solutions as their games are decided.
+  ProgressReporter& progress;
+
+  // num_solved[k]: solutions that took k guesses.
+  std::array<std::atomic<int>, kMaxTrackedGuesses + 1> num_solved{};
+
+  void record(int guesses, int count) {
+    num_solved[std::min(guesses, kMaxTrackedGuesses)] += count;
+    progress.add(count);
+  }
+
+  // out[i]: the pattern guess makes against sols[i].
+  void gather(int guess, const std::vector<int>& sols, typename WordTraits<N>::pattern_t* out) const {
+    if (compressed) {
+      compressed->gather(guess, sols, out);
+      return;
+    }
+    for (int i = 0; i < sols.size(); ++i) {
+      out[i] = disk ? disk->pattern(guess, sols[i]) : (*table->guess_major)[(size_t)guess * solution_list.size() + sols[i]];
+    }
+  }
+
+  int best_guess(const std::vector<int>& guesses, const std::vector<int>& sols) const {
+    if (disk) {
+      return best_guess_swept(*disk, guesses, sols);
+    }
+    if (compressed) {
+      return best_guess_swept(*compressed, guesses, sols);
+    }
+    return best_guess_tiled_by_policy_n<N>(policy, *table, guesses, sols).first;
+  }
+
+  // for tables that hand out one histogram at a time.
+  template <typename Table>
+  int best_guess_swept(const Table& source, const std::vector<int>& guesses, const std::vector<int>& sols) const {
+    return dispatch_scoring_policy(policy, [&](auto p) {
+      using Policy = decltype(p);
+      int best_idx = -1;
+      double best_score = 0.0;
+      source.for_each_histogram(guesses, sols, [&](int idx, const int* counts) {
+	double score = Policy::template score<P>(counts, sols.size());
+	if (best_idx < 0 || score > best_score) {
+	  best_idx = idx;
+	  best_score = score;
+	}
+      });
+      return best_idx;
+    });
+  }
+
+  // guesses_made guesses are behind us, sols are still possible.
+  void play(std::vector<int> sols, std::shared_ptr<const HardModeGuesses> guesses, int guesses_made, int forced_guess) {
+    if (sols.size() == 1) {
+      record(guesses_made + 1, 1);
+      return;
+    }
+    int guess = forced_guess >= 0 ? forced_guess : best_guess(guesses->allowed(), sols);
+    std::vector<typename WordTraits<N>::pattern_t> row(sols.size());
+    gather(guess, sols, row.data());
+    std::vector<std::vector<int>> partitions(P);
+    for (int i = 0; i < sols.size(); ++i) {
+      partitions[row[i]].push_back(sols[i]);
+    }
+    std::vector<bool> wanted(P);
+    for (int p = 1; p < P; ++p) {
+      if (partitions[p].size() == sols.size()) {
+	// the policy picked a guess that can't tell any of them apart. just guess them in turn.
+	for (int i = 0; i < sols.size(); ++i) {
+	  record(guesses_made + 1 + i, 1);
+	}
+	return;
+      }
+      wanted[p] = !partitions[p].empty();
+    }
+    record(guesses_made + 1, partitions[0].size());
+    std::vector<HardModeGuesses> child_guesses;
+    if (hard_mode) {
+      child_guesses = guesses->split(guess_list.at(guess), wanted);
+    }
+    for (int p = 1; p < P; ++p) {
+      if (!wanted[p]) {
+	continue;
+      }
+      auto child = hard_mode ? std::make_shared<const HardModeGuesses>(std::move(child_guesses.at(p))) : guesses;
+      auto part = std::make_shared<std::vector<int>>(std::move(partitions[p]));
+      scheduler.spawn([this, part, child, guesses_made]() { play(std::move(*part), child, guesses_made + 1, -1); });
+    }
+  }
+};
+
+template <int N>
+int run_simulation(ScoringPolicy policy, bool hard_mode, const std::string& opener, const std::string& solutions_file, const std::string& out_of_core_path, bool compress, int num_threads) {
+  std::vector<std::string> guess_list = load_guess_words(N);
+  std::vector<std::string> solution_list = load_words_of_length(solutions_file, N);
+  if (solution_list.empty()) {
+    // solutions.txt only has 5-letter words; for other lengths every word can be the answer,
+    // unless --solutions names a list.
+    solution_list = guess_list;
+  }
+  std::cout << N << "-letter words: " << guess_list.size() << " guesses, " << solution_list.size() << " solutions" << std::endl;
+  std::vector<typename WordTraits<N>::pattern_t> patterns;
+  std::unique_ptr<TiledPatternTable<N>> table;
+  std::unique_ptr<OutOfCorePatternTable<N>> disk;
+  std::unique_ptr<CompressedPatternTable<N>> compressed;
+  if (compress) {
+    compressed = std::make_unique<CompressedPatternTable<N>>(guess_list, solution_list);
+    std::cout << "compressed the pattern table to " << (compressed->stored_bytes() >> 20) << " MB from " << (compressed->raw_bytes() >> 20) << " MB, " << compressed->num_unique_rows() << " distinct rows" << std::endl;
+  } else if (out_of_core_path.empty()) {
+    patterns = build_pattern_table_n<N>(guess_list, solution_list);
+    table = std::make_unique<TiledPatternTable<N>>(patterns, guess_list.size(), solution_list.size(), patterns.size() * sizeof(patterns[0]) <= kSolutionMajorBudgetBytes);
+  } else {
+    disk = OutOfCorePatternTable<N>::open_or_build(out_of_core_path, guess_list, solution_list);
+    if (!disk) {
+      std::cout << "can't write or read the pattern table at " << out_of_core_path << std::endl;
+      return 1;
+    }
+    std::cout << "streaming the pattern table from " << out_of_core_path << ": " << (disk->stored_bytes() >> 20) << " MB on disk, " << (disk->raw_bytes() >> 20) << " MB uncompressed" << std::endl;
+  }
+
+  std::vector<int> all_sol_idxs(solution_list.size());
+  std::iota(std::begin(all_sol_idxs), std::end(all_sol_idxs), 0);
+  auto all_guesses = std::make_shared<const HardModeGuesses>(guess_list);
+
+  int opener_idx = -1;
+  if (!opener.empty()) {
+    auto it = std::find(guess_list.begin(), guess_list.end(), opener);
+    if (it == guess_list.end()) {
+      std::cout << opener << " is not a valid guess" << std::endl;
+      return 1;
+    }
+    opener_idx = it - guess_list.begin();
+  }
+
+  TaskScheduler scheduler(num_threads);
+  auto progress = std::make_unique<ProgressReporter>("simulate", solution_list.size());
+  Simulation<N> sim{guess_list, solution_list, table.get(), disk.get(), compressed.get(), policy, hard_mode, scheduler, *progress};
+  if (opener_idx < 0) {
+    opener_idx = sim.best_guess(all_guesses->allowed(), all_sol_idxs);
+  }
+  std::cout << "opening with " << guess_list.at(opener_idx) << (hard_mode ? " (hard mode)" : "") << std::endl;
+  sim.play(all_sol_idxs, all_guesses, 0, opener_idx);
+  scheduler.wait();
+  progress.reset();
+
+  int total = 0;
+  int failed = 0;
+  int worst = 0;
+  for (int k = 1; k <= kMaxTrackedGuesses; ++k) {
+    int n = sim.num_solved[k];
+    if (n == 0) {
+      continue;
+    }
+    std::cout << k << " guesses: " << n << std::endl;
+    total += k * n;
+    worst = k;
+    if (k > 6) {
+      failed += n;
+    }
+  }
+  std::cout << "average: " << (double)total / solution_list.size() << " guesses, worst: " << worst << ", more than 6: " << failed << std::endl;
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  // usage: ./simulate [--policy NAME] [--hard] [--opener WORD] [--threads N] [--length 4-8] [--solutions FILE] [--out-of-core FILE] [--compressed] [--status-file FILE] [--word-files]
+  // --status-file keeps a JSON line with the progress of the run in FILE (see progress.h).
+  // --out-of-core keeps the pattern table in FILE (written on first use) and streams it from there.
+  // --compressed keeps it in memory entropy coded, at a fraction of the size.
+  ScoringPolicy policy = ScoringPolicy::kEntropy;
+  bool hard_mode = false;
+  std::string opener;
+  int num_threads = 0;
+  int word_length = 5;
+  std::string solutions_file = "solutions.txt";
+  std::string out_of_core_path;
+  bool compress = false;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--policy" && i + 1 < argc) {
+      if (!parse_scoring_policy(argv[++i], &policy)) {
+	std::cout << "unknown policy " << argv[i] << ", pick one of: " << scoring_policy_names() << std::endl;
+	return 1;
+      }
+    } else if (arg == "--hard") {
+      hard_mode = true;
+    } else if (arg == "--opener" && i + 1 < argc) {
+      opener = argv[++i];
+    } else if (arg == "--threads" && i + 1 < argc) {
+      num_threads = std::stoi(argv[++i]);
+    } else if (arg == "--length" && i + 1 < argc) {
+      word_length = std::stoi(argv[++i]);
+    } else if (arg == "--solutions" && i + 1 < argc) {
+      solutions_file = argv[++i];
+    } else if (arg == "--out-of-core" && i + 1 < argc) {
+      out_of_core_path = argv[++i];
+    } else if (arg == "--compressed") {
+      compress = true;
+    } else if (arg == "--status-file" && i + 1 < argc) {
+      report_status_to(argv[++i]);
+    } else if (arg == "--word-files") {
+      use_word_files();
+    }
+  }
+
+  switch (word_length) {
+  case 4: return run_simulation<4>(policy, hard_mode, opener, solutions_file, out_of_core_path, compress, num_threads);
+  case 5: return run_simulation<5>(policy, hard_mode, opener, solutions_file, out_of_core_path, compress, num_threads);
+  case 6: return run_simulation<6>(policy, hard_mode, opener, solutions_file, out_of_core_path, compress, num_threads);
+  case 7: return run_simulation<7>(policy, hard_mode, opener, solutions_file, out_of_core_path, compress, num_threads);
+  case 8: return run_simulation<8>(policy, hard_mode, opener, solutions_file, out_of_core_path, compress, num_threads);
+  }
+  std::cout << "word length has to be between " << kMinWordLength << " and " << kMaxWordLength << std::endl;
+  return 1;
+}
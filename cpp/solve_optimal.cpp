@@ -0,0 +1,396 @@
+#include "utils.h"
+#include "guess_classes.h"
+#include "shared_table.h"
+#include "task_scheduler.h"
+
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// branch and bound search for the strategy that minimizes the total number of guesses summed
+// over every solution word (equivalently the expected number of guesses). at each node only
+// the top-N entropy guesses are tried, so the result is optimal over that shortlist. guesses
+// that split the solutions identically count once (see guess_classes.h).
+
+constexpr int kInfeasible = std::numeric_limits<int>::max() / 2;
+
+// what a memo entry costs beyond its key: the map node, the bucket and the string itself.
+constexpr size_t kMemoEntryOverhead = 64;
+
+struct OptimalSolver {
+  const std::vector<std::string>& guess_list;
+  const std::vector<std::string>& solution_list;
+  const uint8_t* patterns;
+  // guess idx of each solution word, or -1 if it isn't a valid guess.
+  std::vector<int> sol_to_guess;
+  bool hard_mode;
+  int shortlist_size;
+
+  struct MemoEntry {
+    int value;
+    // if false, value is only a lower bound (the search below it was cut off).
+    bool exact;
+  };
+  std::mutex memo_mutex;
+  std::unordered_map<std::string, MemoEntry> memo;
+  // the memo's size in bytes, keys included (hard mode keys carry the allowed guesses and run to
+  // tens of KB near the root), how much of it is lower bounds, and the most it may take.
+  size_t memo_bytes = 0;
+  size_t lower_bound_bytes = 0;
+  size_t memo_budget;
+  GuessClassCache class_cache;
+
+  OptimalSolver(const std::vector<std::string>& guess_list, const std::vector<std::string>& solution_list, const uint8_t* patterns, bool hard_mode, int shortlist_size, size_t memo_budget)
+    : guess_list(guess_list), solution_list(solution_list), patterns(patterns), hard_mode(hard_mode), shortlist_size(shortlist_size), memo_budget(memo_budget) {
+    std::unordered_map<std::string, int> guess_idx;
+    for (int i = 0; i < guess_list.size(); ++i) {
+      guess_idx[guess_list.at(i)] = i;
+    }
+    for (const auto& word : solution_list) {
+      auto it = guess_idx.find(word);
+      sol_to_guess.push_back(it == guess_idx.end() ? -1 : it->second);
+    }
+  }
+
+  const uint8_t* row(int guess_idx) const {
+    return patterns + (size_t)guess_idx * solution_list.size();
+  }
+
+  // cheapest possible total for n words: one is guessed right away, the rest one guess later.
+  static int lower_bound(int n) {
+    return n <= 1 ? n : 2 * n - 1;
+  }
+
+  // bound from the partition counts of one guess: every word pays for this guess, and each
+  // non-green partition costs at least lower_bound of its size on top.
+  int lower_bound_for_guess(const int* counts, int n) const {
+    int bound = n;
+    for (int p = 1; p < 243; ++p) {
+      bound += lower_bound(counts[p]);
+    }
+    return bound;
+  }
+
+  // the solutions and, in hard mode, the allowed guesses.
+  std::string state_key(const std::vector<int>& sols, const std::vector<int>& guesses) const {
+    std::string key = GuessClassCache::key(sols);
+    if (hard_mode) {
+      // in hard mode the allowed guesses are part of the state. the count keeps the two lists
+      // from running into each other.
+      int num_guesses = guesses.size();
+      key.append((const char*)&num_guesses, sizeof(num_guesses));
+      key.append(GuessClassCache::key(guesses));
+    }
+    return key;
+  }
+
+  std::string memo_key(const std::vector<int>& sols, const std::vector<int>& guesses, int guesses_left) const {
+    return state_key(sols, guesses) + (char)guesses_left;
+  }
+
+  // stores entry for key, raising a lower bound or making it exact if there is one. a new key
+  // that doesn't fit in memo_budget makes room by dropping every lower bound, if they're a
+  // quarter of the memo, and is left out otherwise. exact entries stay once stored. call with
+  // memo_mutex held.
+  void remember(const std::string& key, MemoEntry entry) {
+    const size_t bytes = key.size() + kMemoEntryOverhead;
+    auto it = memo.find(key);
+    if (it != memo.end()) {
+      if (entry.exact && !it->second.exact) {
+	lower_bound_bytes -= bytes;
+	it->second = entry;
+      } else if (!it->second.exact) {
+	it->second.value = std::max(it->second.value, entry.value);
+      }
+      return;
+    }
+    if (memo_bytes + bytes > memo_budget && lower_bound_bytes >= memo_budget / 4) {
+      for (auto it = memo.begin(); it != memo.end();) {
+	if (it->second.exact) {
+	  ++it;
+	} else {
+	  memo_bytes -= it->first.size() + kMemoEntryOverhead;
+	  it = memo.erase(it);
+	}
+      }
+      lower_bound_bytes = 0;
+    }
+    if (memo_bytes + bytes > memo_budget) {
+      return;
+    }
+    memo.emplace(key, entry);
+    memo_bytes += bytes;
+    if (!entry.exact) {
+      lower_bound_bytes += bytes;
+    }
+  }
+
+  // classes of the guesses over sols, refined from the parent node's. in hard mode the parent's
+  // representative may no longer be allowed while another member is, so classify afresh.
+  std::shared_ptr<const GuessClasses> classes_for(const std::vector<int>& sols, const std::vector<int>& guesses, const GuessClasses& parent_classes) {
+    std::string key = state_key(sols, guesses);
+    if (auto classes = class_cache.find(key)) {
+      return classes;
+    }
+    return class_cache.insert(key, hard_mode ?
+      classify_guesses(patterns, solution_list.size(), guesses, sols) :
+      refine_guess_classes(parent_classes, patterns, solution_list.size(), sols));
+  }
+
+  // top shortlist_size guesses by entropy that actually split sols. for small sets the
+  // candidates themselves are always included since they can end the game right away.
+  std::vector<int> shortlist(const std::vector<int>& sols, const std::vector<int>& guesses) const {
+    std::vector<std::pair<double, int>> scored;
+    for (int g : guesses) {
+      scored.push_back(std::make_pair(calc_entropy_from_patterns(row(g), sols), g));
+    }
+    std::sort(scored.begin(), scored.end(), [](const std::pair<double, int>& a, const std::pair<double, int>& b) {
+      return a.first != b.first ? a.first > b.first : a.second < b.second; });
+    std::vector<int> out;
+    for (int i = 0; i < scored.size() && i < shortlist_size; ++i) {
+      if (scored.at(i).first > 0.0) {
+	out.push_back(scored.at(i).second);
+      }
+    }
+    if (sols.size() <= shortlist_size) {
+      for (int s : sols) {
+	int g = sol_to_guess.at(s);
+	if (g >= 0 && std::find(out.begin(), out.end(), g) == out.end() &&
+	    (!hard_mode || std::find(guesses.begin(), guesses.end(), g) != guesses.end())) {
+	  out.push_back(g);
+	}
+      }
+    }
+    return out;
+  }
+
+  // guesses still allowed after guessing `guess` and seeing `pattern`.
+  std::vector<int> constrain_guesses(const std::vector<int>& guesses, int guess, int pattern) const {
+    if (!hard_mode) {
+      return guesses;
+    }
+    std::vector<int> out;
+    for (int g : guesses) {
+      if (calc_pattern(guess_list.at(guess), guess_list.at(g)) == pattern) {
+	out.push_back(g);
+      }
+    }
+    return out;
+  }
+
+  // total guesses needed to solve every word in sols with guess as the next guess, or
+  // something >= cutoff if that can't beat cutoff. classes are the guess classes over sols.
+  int cost_with_guess(const std::vector<int>& sols, const std::vector<int>& guesses, const GuessClasses& classes, int guesses_left, int guess, int cutoff) {
+    std::vector<std::vector<int>> partitions(243);
+    for (int s : sols) {
+      partitions[row(guess)[s]].push_back(s);
+    }
+    int counts[243];
+    for (int p = 0; p < 243; ++p) {
+      counts[p] = partitions[p].size();
+    }
+    int bound = lower_bound_for_guess(counts, sols.size());
+    if (bound >= cutoff) {
+      return bound;
+    }
+    // biggest partitions first: they dominate the cost and make the cutoff bite early.
+    std::vector<int> order;
+    for (int p = 1; p < 243; ++p) {
+      if (counts[p] > 0) {
+	order.push_back(p);
+      }
+    }
+    std::sort(order.begin(), order.end(), [&counts](int a, int b) { return counts[a] > counts[b]; });
+    int total = bound;
+    for (int p : order) {
+      total -= lower_bound(counts[p]);
+      int sub = solve(partitions[p], constrain_guesses(guesses, guess, p), classes, guesses_left - 1, cutoff - total);
+      total += sub;
+      if (total >= cutoff) {
+	return total;
+      }
+    }
+    return total;
+  }
+
+  // minimum total guesses to solve every word in sols within guesses_left guesses, or
+  // something >= cutoff if that is not below cutoff. parent_classes are the guess classes of
+  // the node above.
+  int solve(const std::vector<int>& sols, const std::vector<int>& guesses, const GuessClasses& parent_classes, int guesses_left, int cutoff) {
+    int n = sols.size();
+    if (n == 0) {
+      return 0;
+    }
+    if (guesses_left <= 0) {
+      return kInfeasible;
+    }
+    if (n == 1) {
+      return 1;
+    }
+    if (guesses_left == 1) {
+      return kInfeasible;
+    }
+    if (lower_bound(n) >= cutoff) {
+      return lower_bound(n);
+    }
+
+    std::string key = memo_key(sols, guesses, guesses_left);
+    {
+      std::lock_guard<std::mutex> lock(memo_mutex);
+      auto it = memo.find(key);
+      if (it != memo.end() && (it->second.exact || it->second.value >= cutoff)) {
+	return it->second.value;
+      }
+    }
+
+    auto classes = classes_for(sols, guesses, parent_classes);
+    int best = cutoff;
+    for (int g : shortlist(sols, classes->representatives)) {
+      int cost = cost_with_guess(sols, guesses, *classes, guesses_left, g, best);
+      if (cost < best) {
+	best = cost;
+	if (best == lower_bound(n)) {
+	  break;
+	}
+      }
+    }
+
+    std::lock_guard<std::mutex> lock(memo_mutex);
+    if (best < cutoff) {
+      remember(key, {best, true});
+    } else {
+      remember(key, {cutoff, false});
+    }
+    return best;
+  }
+
+  // total guesses when always taking the max entropy guess, for comparison.
+  int greedy_cost(const std::vector<int>& sols, const std::vector<int>& guesses, int guesses_left) {
+    if (sols.size() <= 1) {
+      return sols.size();
+    }
+    if (guesses_left <= 1) {
+      return kInfeasible;
+    }
+    int best_guess = -1;
+    double best_ent = -1.0;
+    for (int g : guesses) {
+      double ent = calc_entropy_from_patterns(row(g), sols);
+      if (ent > best_ent) {
+	best_ent = ent;
+	best_guess = g;
+      }
+    }
+    std::vector<std::vector<int>> partitions(243);
+    for (int s : sols) {
+      partitions[row(best_guess)[s]].push_back(s);
+    }
+    int total = sols.size();
+    for (int p = 1; p < 243; ++p) {
+      if (!partitions[p].empty()) {
+	total = std::min(kInfeasible, total + greedy_cost(partitions[p], constrain_guesses(guesses, best_guess, p), guesses_left - 1));
+      }
+    }
+    return total;
+  }
+};
+
+// finished root guesses: guess,total. lets a long run pick up where it left off.
+std::map<std::string, int> load_progress(const std::string& filename) {
+  std::ifstream in(filename);
+  std::map<std::string, int> progress;
+  std::string str;
+  while (std::getline(in, str)) {
+    int comma_pos = str.find(',');
+    progress[str.substr(0, comma_pos)] = std::stoi(str.substr(comma_pos + 1));
+  }
+  return progress;
+}
+
+int main(int argc, char** argv) {
+  // usage: ./solve_optimal [--hard] [--shortlist N] [--threads N] [--max-guesses N] [--memo-mb N] [--table-dir DIR] [--word-files]
+  // --table-dir shares the pattern table with other processes through DIR (e.g. /dev/shm).
+  // --memo-mb caps the memo (default 1024 MB); past it the search is slower, not different.
+  bool hard_mode = false;
+  int shortlist_size = 20;
+  int num_threads = 0;
+  int max_guesses = 6;
+  size_t memo_mb = 1024;
+  std::string table_dir;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--hard") {
+      hard_mode = true;
+    } else if (arg == "--word-files") {
+      use_word_files();
+    } else if (arg == "--shortlist" && i + 1 < argc) {
+      shortlist_size = std::stoi(argv[++i]);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      num_threads = std::stoi(argv[++i]);
+    } else if (arg == "--max-guesses" && i + 1 < argc) {
+      max_guesses = std::stoi(argv[++i]);
+    } else if (arg == "--memo-mb" && i + 1 < argc) {
+      memo_mb = std::stoul(argv[++i]);
+    } else if (arg == "--table-dir" && i + 1 < argc) {
+      table_dir = argv[++i];
+    }
+  }
+
+  std::vector<std::string> guess_list = load_guess_words();
+  std::vector<std::string> solution_list = load_sol_words();
+  PatternTable patterns = table_dir.empty() ? PatternTable::build(guess_list, solution_list) : PatternTable::open_shared(table_dir, guess_list, solution_list);
+
+  std::vector<int> all_sol_idxs(solution_list.size());
+  std::iota(std::begin(all_sol_idxs), std::end(all_sol_idxs), 0);
+  std::vector<int> all_guess_idxs(guess_list.size());
+  std::iota(std::begin(all_guess_idxs), std::end(all_guess_idxs), 0);
+
+  OptimalSolver solver(guess_list, solution_list, patterns.data(), hard_mode, shortlist_size, memo_mb << 20);
+
+  // totals only carry over between runs with the same settings and word lists, so those are in the name.
+  std::ostringstream progress_name;
+  progress_name << (hard_mode ? "optimal_hard" : "optimal") << "_s" << shortlist_size << "_g" << max_guesses << "_" << std::hex << hash_word_lists(guess_list, solution_list) << ".checkpoint";
+  const std::string progress_file = progress_name.str();
+  std::map<std::string, int> progress = load_progress(progress_file);
+  std::cout << "resuming with " << progress.size() << " opening guesses already solved" << std::endl;
+
+  // each opening guess on the shortlist is an independent subtree; the memo is shared.
+  GuessClasses root_classes = singleton_guess_classes(all_guess_idxs);
+  std::vector<int> openers = solver.shortlist(all_sol_idxs, all_guess_idxs);
+  std::mutex progress_mutex;
+  {
+    TaskScheduler scheduler(num_threads);
+    for (int g : openers) {
+      const std::string& word = guess_list.at(g);
+      if (progress.find(word) != progress.end()) {
+	continue;
+      }
+      scheduler.spawn([&, g, word]() {
+	int total = solver.cost_with_guess(all_sol_idxs, all_guess_idxs, root_classes, max_guesses, g, kInfeasible);
+	std::lock_guard<std::mutex> lock(progress_mutex);
+	progress[word] = total;
+	std::ofstream out(progress_file, std::ios::app);
+	out << word << "," << total << std::endl;
+	std::cout << word << " needs " << total << " guesses in total" << std::endl;
+      });
+    }
+  }
+
+  auto best = std::min_element(progress.begin(), progress.end(), [](const std::pair<const std::string, int>& a, const std::pair<const std::string, int>& b) {
+    return a.second < b.second; });
+  if (best == progress.end() || best->second >= kInfeasible) {
+    std::cout << "no strategy solves every word within " << max_guesses << " guesses" << std::endl;
+    return 1;
+  }
+  int greedy = solver.greedy_cost(all_sol_idxs, all_guess_idxs, max_guesses);
+  double n = solution_list.size();
+  std::cout << "optimal" << (hard_mode ? " (hard mode)" : "") << ": open with " << best->first << ", " << best->second << " guesses in total, " << best->second / n << " on average" << std::endl;
+  std::cout << "greedy: " << greedy << " guesses in total, " << greedy / n << " on average" << std::endl;
+  std::cout << "greedy is " << greedy - best->second << " guesses (" << (greedy - best->second) / n << " per word) worse than optimal" << std::endl;
+}
@@ -1,92 +1,87 @@
+#include <chrono>
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <map>
+#include <memory>
 #include <math.h>
 #include <numeric>
 
-#include "cppitertools/product.hpp"
 #include "utils.h"
+#include "endgame.h"
+#include "prefilter.h"
+#include "progress.h"
+#include "scoring.h"
+#include "wordle_core.h"
 
-std::vector<std::function<bool(const std::string&)>> parse_constraints_string(const std::string& constraints_string) {
-  if (constraints_string.empty()) {
-    return {};
-  }
-  std::vector<std::function<bool(const std::string&)>> constraints = {};
-
-  std::vector<std::function<bool(const std::string&, const char, int)>> raw_constraints;
-
-  raw_constraints.push_back(has_letter_at_pos);
-  raw_constraints.push_back(has_letter_not_at_pos);
-  raw_constraints.push_back(does_not_have_letter);
-
-  for (int i = 0; i < constraints_string.size(); i+= 2) {
-    char letter = constraints_string.at(i);
-    int idx = (int)(constraints_string.at(i+1))-(int)('0') - 1;
-    constraints.push_back(std::bind(raw_constraints.at(idx), std::placeholders::_1, letter, i/2));
+int main(int argc, char** argv) {
+  // usage: ./solve_wordle [--hard] [--policy NAME] [--approximate] [--budget-ms N] [--threads N] [--status-file FILE] [--word-files]
+  // --approximate takes the best entropy among the prefilter's shortlist without proving it.
+  // --budget-ms answers every turn within about N ms with the best guess found by then, scored
+  // on --threads threads (default 1, 0 for every core). --status-file keeps the progress of a
+  // checkpoint sweep in FILE (see progress.h).
+  bool hard_mode = false;
+  bool exact = true;
+  int budget_ms = 0;
+  int num_threads = 1;
+  ScoringPolicy policy = ScoringPolicy::kEntropy;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--hard") {
+      hard_mode = true;
+    } else if (arg == "--approximate") {
+      exact = false;
+    } else if (arg == "--status-file" && i + 1 < argc) {
+      report_status_to(argv[++i]);
+    } else if (arg == "--word-files") {
+      use_word_files();
+    } else if (arg == "--budget-ms" && i + 1 < argc) {
+      budget_ms = std::stoi(argv[++i]);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      num_threads = std::stoi(argv[++i]);
+    } else if (arg == "--policy" && i + 1 < argc) {
+      if (!parse_scoring_policy(argv[++i], &policy)) {
+	std::cout << "unknown policy " << argv[i] << ", pick one of: " << scoring_policy_names() << std::endl;
+	return 1;
+      }
+    }
   }
-  return constraints;
-}
 
-int main() {
   // get list of words
-  std::vector<std::string> guess_words = load_guess_words();
-  std::vector<std::string> sol_words = load_sol_words();
+  auto dictionary = Dictionary::load({});
+  const auto& guess_words = dictionary->guess_words();
+  const auto& sol_words = dictionary->sol_words();
   std::cout << "number of five letter guess words: " << guess_words.size() << std::endl;
 
-  std::vector<int> constrained_guess_idxs(guess_words.size());
-  std::iota(std::begin(constrained_guess_idxs), std::end(constrained_guess_idxs), 0);
-
-  std::vector<int> constrained_sol_idxs(sol_words.size());
-  std::iota(std::begin(constrained_sol_idxs), std::end(constrained_sol_idxs), 0);
-
+  // the candidates left and, in hard mode, the guesses still consistent with the feedback so far.
+  Session session(*dictionary, hard_mode);
+  const std::vector<int>& constrained_sol_idxs = session.candidates();
+  std::unique_ptr<TaskScheduler> scheduler;
+  if (num_threads != 1) {
+    scheduler = std::make_unique<TaskScheduler>(num_threads);
+  }
 
-  auto [guess,ent] = get_best_word(guess_words, constrained_guess_idxs, sol_words, constrained_sol_idxs, /*use_cache=*/true);
-  std::cout << guess << " has highest entropy of " << ent << std::endl;
+  // the entropy checkpoint only helps the entropy policy; the others score the opener from scratch.
+  if (policy == ScoringPolicy::kEntropy) {
+    auto [guess,ent] = get_best_word(guess_words, session.allowed_guesses(), sol_words, constrained_sol_idxs, /*use_cache=*/true);
+    std::cout << guess << " has highest entropy of " << ent << std::endl;
+  } else {
+    auto [guess,score] = get_best_word_by_policy(policy, guess_words, session.allowed_guesses(), sol_words, constrained_sol_idxs);
+    std::cout << guess << " has highest score of " << score << std::endl;
+  }
 
-  std::string constraints_string;
-  std::vector<std::function<bool(const std::string&)>> constraints;
+  std::string last_guess;
+  int pattern;
   while (true) {
-    std::cout << "Please input constraint string: (ex. t1e2a2r3s3 would mean the word contains a 't' in the correct position, 'e' and 'a' in wrong positions and does not contain 'r' or 's')\n" << std::endl;
-    std::cin >> constraints_string;
-    std::vector<std::function<bool(const std::string&)>> new_constraints = parse_constraints_string(constraints_string);
-    constraints.insert(constraints.end(), new_constraints.begin(), new_constraints.end());
-    // recompute constrained_word_idxs
-    {
-      std::vector<int> temp;
-      for (const int idx : constrained_guess_idxs) {
-	bool failed_constraint = false;
-	const auto& guess = guess_words.at(idx);
-	for (const auto& constraint : constraints) {
-	  if (!constraint(guess)) {
-	    failed_constraint = true;
-	    break;
-	  }
-	}
-	if (!failed_constraint) {
-	  temp.push_back(idx);
-	}
-      }
-      constrained_guess_idxs = temp;
+    std::cout << "Please input the guess and its colours (ex. tares GBYYB would mean the word has a 't' in the correct position, 'r' and 'e' in wrong positions and no 'a' or 's'), or a constraint string (ex. t1e2a2r3s3 would mean the word contains a 't' in the correct position, 'e' and 'a' in wrong positions and does not contain 'r' or 's')\n" << std::endl;
+    if (!read_feedback(std::cin, &last_guess, &pattern)) {
+      return 0;
     }
-
-    // do the same for sols
-    {
-      std::vector<int> temp;
-      for (const int idx : constrained_sol_idxs) {
-	bool failed_constraint = false;
-	const auto& sol = sol_words.at(idx);
-	for (const auto& constraint : constraints) {
-	  if (!constraint(sol)) {
-	    failed_constraint = true;
-	    break;
-	  }
-	}
-	if (!failed_constraint) {
-	  temp.push_back(idx);
-	}
-      }
-      constrained_sol_idxs = temp;
+    SearchLimits limits;
+    limits.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(budget_ms);
+    if (!session.apply_feedback(last_guess, pattern)) {
+      std::cout << "expected a five letter guess and five of G/Y/B, or five letters each followed by 1, 2 or 3" << std::endl;
+      continue;
     }
 
     if (constrained_sol_idxs.size() == 1) {
@@ -96,7 +91,21 @@ int main() {
       std::cout << "no words found matching all constraints. either a bug or vocab isn't big enough" << std::endl;
       return 0;
     }
-    auto [next_guess, ent] = get_best_word(guess_words, constrained_guess_idxs, sol_words, constrained_sol_idxs, /*use_cache=*/false);
-    std::cout << "let's guess: " << next_guess << " which has entropy: " << ent << std::endl;
+    if (policy == ScoringPolicy::kEntropy && budget_ms > 0 && constrained_sol_idxs.size() > kEndgameThreshold) {
+      AnytimeResult result = get_best_word_anytime(guess_words, session.allowed_guesses(), sol_words, constrained_sol_idxs, limits, scheduler.get());
+      std::cout << "(scored " << result.num_evaluated << " of " << session.allowed_guesses().size() << " guesses, " << (result.proven ? "none of the rest can do better" : "out of time") << ")" << std::endl;
+      std::cout << "let's guess: " << guess_words.at(result.guess) << " which has entropy: " << result.entropy << std::endl;
+    } else if (policy == ScoringPolicy::kEntropy && budget_ms > 0) {
+      EndgameSolver solver(guess_words, session.allowed_guesses(), sol_words, constrained_sol_idxs, &limits);
+      const std::string& next_guess = guess_words.at(solver.best_guess().first);
+      std::cout << "(" << (solver.complete() ? "endgame search finished" : "out of time, taking the best guess found so far") << ")" << std::endl;
+      std::cout << "let's guess: " << next_guess << " which has entropy: " << calc_entropy_for_word(next_guess, sol_words, constrained_sol_idxs) << std::endl;
+    } else if (policy == ScoringPolicy::kEntropy) {
+      auto [next_guess, ent] = choose_guess(guess_words, session.allowed_guesses(), sol_words, constrained_sol_idxs, /*use_cache=*/false, exact);
+      std::cout << "let's guess: " << next_guess << " which has entropy: " << ent << std::endl;
+    } else {
+      auto [next_guess, score] = get_best_word_by_policy(policy, guess_words, session.allowed_guesses(), sol_words, constrained_sol_idxs);
+      std::cout << "let's guess: " << next_guess << " which has score: " << score << std::endl;
+    }
   }
 }
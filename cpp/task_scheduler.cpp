@@ -0,0 +1,90 @@
+#include "task_scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+// which worker (if any) the current thread is. -1 for threads outside the scheduler.
+thread_local int tls_worker_id = -1;
+thread_local const TaskScheduler* tls_scheduler = nullptr;
+}
+
+TaskScheduler::TaskScheduler(int num_threads) {
+  if (num_threads <= 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    threads_.emplace_back(&TaskScheduler::run_worker, this, i);
+  }
+}
+
+TaskScheduler::~TaskScheduler() {
+  wait();
+  stop_ = true;
+  sleep_cv_.notify_all();
+  for (auto& t : threads_) {
+    t.join();
+  }
+}
+
+void TaskScheduler::spawn(Task task) {
+  pending_.fetch_add(1);
+  int id = tls_scheduler == this ? tls_worker_id : next_external_.fetch_add(1) % workers_.size();
+  {
+    std::lock_guard<std::mutex> lock(workers_.at(id)->mutex);
+    workers_.at(id)->tasks.push_back(std::move(task));
+  }
+  sleep_cv_.notify_one();
+}
+
+void TaskScheduler::wait() {
+  std::unique_lock<std::mutex> lock(sleep_mutex_);
+  done_cv_.wait(lock, [this]() { return pending_.load() == 0; });
+}
+
+bool TaskScheduler::pop_local(int id, Task& task) {
+  auto& w = *workers_.at(id);
+  std::lock_guard<std::mutex> lock(w.mutex);
+  if (w.tasks.empty()) {
+    return false;
+  }
+  task = std::move(w.tasks.back());
+  w.tasks.pop_back();
+  return true;
+}
+
+bool TaskScheduler::steal(int id, Task& task) {
+  for (int i = 1; i < workers_.size(); ++i) {
+    auto& victim = *workers_.at((id + i) % workers_.size());
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void TaskScheduler::run_worker(int id) {
+  tls_worker_id = id;
+  tls_scheduler = this;
+  Task task;
+  while (!stop_) {
+    if (pop_local(id, task) || steal(id, task)) {
+      task();
+      task = nullptr;
+      if (pending_.fetch_sub(1) == 1) {
+	std::lock_guard<std::mutex> lock(sleep_mutex_);
+	done_cv_.notify_all();
+      }
+      continue;
+    }
+    // nothing to do. sleep until somebody spawns; the timeout covers a spawn racing with us.
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    sleep_cv_.wait_for(lock, std::chrono::milliseconds(1));
+  }
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// work-stealing task scheduler. each worker owns a deque: it pushes and pops its own
+// tasks at the back (depth-first, cache friendly) and steals from the front of the other
+// workers' deques (the oldest, usually biggest, tasks) when it runs dry.
+class TaskScheduler {
+ public:
+  using Task = std::function<void()>;
+
+  // num_threads <= 0 means use every core.
+  explicit TaskScheduler(int num_threads = 0);
+  ~TaskScheduler();
+
+  // safe to call from inside a running task; the new task goes on the caller's own deque.
+  void spawn(Task task);
+
+  // block until every spawned task, and everything those tasks spawned, has finished.
+  void wait();
+
+  int num_threads() const { return workers_.size(); }
+
+ private:
+  struct Worker {
+    std::deque<Task> tasks;
+    std::mutex mutex;
+  };
+
+  bool pop_local(int id, Task& task);
+  bool steal(int id, Task& task);
+  void run_worker(int id);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+  std::atomic<int> pending_{0};
+  std::atomic<int> next_external_{0};
+  std::atomic<bool> stop_{false};
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
+  std::condition_variable done_cv_;
+};
+
+// raise target to value if value is bigger. lock free.
+template <typename T>
+void atomic_max(std::atomic<T>& target, T value) {
+  T cur = target.load(std::memory_order_relaxed);
+  while (cur < value && !target.compare_exchange_weak(cur, value, std::memory_order_relaxed)) {
+  }
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "word_length.h"
+
+// cache-blocked guess x candidate sweeps over the pattern table. instead of streaming one
+// guess's row at a time, a block of guesses is run against a block of candidates, so the
+// candidate index list and the block's histograms stay in cache while the table goes by.
+//
+// the table comes in two layouts. guess-major (build_pattern_table_n) reads a row per guess
+// and gathers the candidates out of it, which is fine while most solutions are candidates but
+// touches a whole cache line per candidate once they're sparse. solution-major (the transpose)
+// reads a row per candidate and walks the guesses contiguously, so it only touches the rows
+// of candidates that are left. best_guess_tiled_n picks whichever reads less, and sweeps the
+// guess-major table a row at a time rather than tiled, since tiling it measured no faster.
+
+enum class PatternLayout {
+  kGuessMajor,
+  kSolutionMajor,
+};
+
+struct TileSize {
+  // guesses per block: their histograms (guesses * 3^N ints) should stay in L2.
+  int guesses = 64;
+  // candidates per block: their indices should stay in L1.
+  int sols = 2048;
+};
+
+// both layouts of one guess x solution table. the solution-major copy is optional since it
+// doubles the memory.
+template <int N>
+struct TiledPatternTable {
+  using pattern_t = typename WordTraits<N>::pattern_t;
+
+  const std::vector<pattern_t>* guess_major;
+  std::vector<pattern_t> solution_major;
+  int num_guesses;
+  int num_sols;
+
+  TiledPatternTable(const std::vector<pattern_t>& guess_major, int num_guesses, int num_sols, bool with_solution_major)
+    : guess_major(&guess_major), num_guesses(num_guesses), num_sols(num_sols) {
+    if (!with_solution_major) {
+      return;
+    }
+    solution_major.resize(guess_major.size());
+    // transpose in tiles too, so neither side is read or written with a large stride.
+    const int tile = 64;
+    for (int g0 = 0; g0 < num_guesses; g0 += tile) {
+      for (int s0 = 0; s0 < num_sols; s0 += tile) {
+	for (int g = g0; g < std::min(num_guesses, g0 + tile); ++g) {
+	  for (int s = s0; s < std::min(num_sols, s0 + tile); ++s) {
+	    solution_major[(size_t)s * num_guesses + g] = guess_major[(size_t)g * num_sols + s];
+	  }
+	}
+      }
+    }
+  }
+
+  bool has_solution_major() const { return !solution_major.empty(); }
+
+  // bytes of table a sweep touches in each layout, counting whole 64-byte lines.
+  size_t bytes_read(PatternLayout layout, int num_sweep_guesses, int num_sweep_sols) const {
+    auto lines = [](size_t useful, size_t row_bytes) { return std::min(row_bytes, useful * 64); };
+    if (layout == PatternLayout::kGuessMajor) {
+      return num_sweep_guesses * lines(num_sweep_sols, (size_t)num_sols * sizeof(pattern_t));
+    }
+    return num_sweep_sols * lines(num_sweep_guesses, (size_t)num_guesses * sizeof(pattern_t));
+  }
+
+  PatternLayout choose_layout(int num_sweep_guesses, int num_sweep_sols) const {
+    if (!has_solution_major()) {
+      return PatternLayout::kGuessMajor;
+    }
+    return bytes_read(PatternLayout::kSolutionMajor, num_sweep_guesses, num_sweep_sols) < bytes_read(PatternLayout::kGuessMajor, num_sweep_guesses, num_sweep_sols) ?
+      PatternLayout::kSolutionMajor : PatternLayout::kGuessMajor;
+  }
+};
+
+// calls f(guess idx, counts) for every guess in constrained_guess_idxs, in order, with its
+// histogram over constrained_sol_idxs (3^N ints). one block of histograms is live at a time.
+template <int N, typename F>
+void for_each_histogram_tiled(const TiledPatternTable<N>& table, PatternLayout layout, const std::vector<int>& constrained_guess_idxs, const std::vector<int>& constrained_sol_idxs, F&& f, TileSize tile = TileSize()) {
+  constexpr int P = WordTraits<N>::kNumPatterns;
+  std::vector<int> counts((size_t)tile.guesses * P);
+  const int num_guesses = constrained_guess_idxs.size();
+  const int num_sols = constrained_sol_idxs.size();
+  for (int g0 = 0; g0 < num_guesses; g0 += tile.guesses) {
+    const int g1 = std::min(num_guesses, g0 + tile.guesses);
+    std::fill(counts.begin(), counts.end(), 0);
+    if (layout == PatternLayout::kGuessMajor) {
+      for (int s0 = 0; s0 < num_sols; s0 += tile.sols) {
+	const int s1 = std::min(num_sols, s0 + tile.sols);
+	for (int g = g0; g < g1; ++g) {
+	  const auto* row = table.guess_major->data() + (size_t)constrained_guess_idxs[g] * table.num_sols;
+	  int* c = counts.data() + (size_t)(g - g0) * P;
+	  for (int s = s0; s < s1; ++s) {
+	    c[row[constrained_sol_idxs[s]]]++;
+	  }
+	}
+      }
+    } else {
+      for (int s = 0; s < num_sols; ++s) {
+	const auto* row = table.solution_major.data() + (size_t)constrained_sol_idxs[s] * table.num_guesses;
+	for (int g = g0; g < g1; ++g) {
+	  counts[(size_t)(g - g0) * P + row[constrained_guess_idxs[g]]]++;
+	}
+      }
+    }
+    for (int g = g0; g < g1; ++g) {
+      f(constrained_guess_idxs[g], counts.data() + (size_t)(g - g0) * P);
+    }
+  }
+}
+
+// best_guess_from_patterns_n, switching to the tiled solution-major sweep once that reads less.
+// while guess-major reads less the rows are swept one at a time, untiled: over every solution
+// bench_sweep has the tiled guess-major sweep 5-15% slower than that (42.3 vs 39.8 ms here,
+// 60.9 vs 51.0 ms on another machine), so tiling it is left to the benchmark. same result
+// either way, ties go to the first guess.
+template <typename Policy, int N>
+std::pair<int, double> best_guess_tiled_n(const TiledPatternTable<N>& table, const std::vector<int>& constrained_guess_idxs, const std::vector<int>& constrained_sol_idxs) {
+  constexpr int P = WordTraits<N>::kNumPatterns;
+  int best_idx = -1;
+  double best_score = 0.0;
+  auto consider = [&](int idx, const int* counts) {
+    double score = Policy::template score<P>(counts, constrained_sol_idxs.size());
+    if (best_idx < 0 || score > best_score) {
+      best_idx = idx;
+      best_score = score;
+    }
+  };
+  if (table.choose_layout(constrained_guess_idxs.size(), constrained_sol_idxs.size()) == PatternLayout::kSolutionMajor) {
+    for_each_histogram_tiled(table, PatternLayout::kSolutionMajor, constrained_guess_idxs, constrained_sol_idxs, consider);
+  } else {
+    int counts[P];
+    for (int idx : constrained_guess_idxs) {
+      calc_pattern_counts_n<N>(table.guess_major->data() + (size_t)idx * table.num_sols, constrained_sol_idxs, counts);
+      consider(idx, counts);
+    }
+  }
+  return std::make_pair(best_idx, best_score);
+}
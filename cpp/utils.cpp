@@ -1,46 +1,69 @@
 #include "utils.h"
+#include "dictionary.h"
+#include "progress.h"
+#ifdef WORDLE_EMBEDDED
+#include "embedded_words.h"
+#endif
 
+#include <cctype>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <numeric>
+#include <tuple>
 
-// entropy of discrete random variable.
-double entropy(const std::vector<double>& prob_vec) {
-  double ent;
-  for (const double prob : prob_vec) {
-    if (prob == 0) {
-      continue;
-    }
-    ent += (prob * log2(prob));
-  }
-  return -1.0 * ent;
-}
-
-std::vector<std::string> load_guess_words() {
-  std::ifstream in("sowpods.txt");
+std::vector<std::vector<std::string>> load_words_by_length(const std::string& filename) {
+  std::ifstream in(filename);
   std::string str;
-  std::vector<std::string> words;
+  std::vector<std::vector<std::string>> words(kMaxWordLength + 1);
   while (std::getline(in, str)) {
-    if (str.size() == 5) {
-      words.push_back(str);
+    if (str.size() <= kMaxWordLength) {
+      words[str.size()].push_back(str);
     }
   }
   return words;
 }
 
-std::vector<std::string> load_sol_words() {
-  std::ifstream in("solutions.txt");
-  std::string str;
+namespace {
+
+bool word_files_only = false;
+
+}  // namespace
+
+void use_word_files() {
+  word_files_only = true;
+}
+
+std::vector<std::string> load_words_of_length(const std::string& filename, int word_length) {
   std::vector<std::string> words;
-  while (std::getline(in, str)) {
-    if (str.size() == 5) {
-      words.push_back(str);
+  if (word_files_only) {
+    return load_words_by_length(filename).at(word_length);
+  }
+#ifdef WORDLE_EMBEDDED
+  for (const auto& list : kEmbeddedWordLists) {
+    if (filename == list.source && word_length == list.word_length) {
+      words.reserve(list.num_words);
+      for (int i = 0; i < list.num_words; ++i) {
+	words.emplace_back(list.words + i * word_length, word_length);
+      }
+      return words;
     }
   }
-  return words;
+#endif
+  if (load_words_from_dictionary(filename, word_length, &words)) {
+    return words;
+  }
+  return load_words_by_length(filename).at(word_length);
 }
 
+std::vector<std::string> load_guess_words(int word_length) {
+  return load_words_of_length("sowpods.txt", word_length);
+}
 
+std::vector<std::string> load_sol_words(int word_length) {
+  return load_words_of_length("solutions.txt", word_length);
+}
 
 std::vector<std::string> load_words_test_small() {
   return {
@@ -61,6 +84,15 @@ std::vector<std::string> load_words_test_small() {
 // }
 
 std::map<std::string, double> load_checkpoint() {
+#ifdef WORDLE_EMBEDDED
+  if (!word_files_only) {
+    std::map<std::string, double> entrop_dict;
+    for (int i = 0; i < kNumEmbeddedScores; ++i) {
+      entrop_dict.emplace_hint(entrop_dict.end(), std::string(kEmbeddedScoreWords + i * 5, 5), kEmbeddedScores[i]);
+    }
+    return entrop_dict;
+  }
+#endif
   std::ifstream in("wordle.checkpoint");
   if (!in.good()) {
     return {};
@@ -69,7 +101,7 @@ std::map<std::string, double> load_checkpoint() {
   std::map<std::string, double> entrop_dict;
   while (std::getline(in, str)) {
     int comma_pos = str.find(',');
-    entrop_dict[str.substr(0,5)] = std::stod(str.substr(6));
+    entrop_dict[str.substr(0, comma_pos)] = std::stod(str.substr(comma_pos + 1));
   }
   in.close();
   return entrop_dict;
@@ -83,44 +115,110 @@ void save_checkpoint(const std::map<std::string, double>& entrop_dict) {
   out.close();
 }
 
-bool has_letter_at_pos(const std::string& word, const char letter, int pos) {
-  return word.at(pos) == letter;
+int calc_pattern(const std::string& query, const std::string& word) {
+  return calc_pattern_n<5>(query.data(), word.data());
 }
 
-bool has_letter_not_at_pos(const std::string& word, const char letter, int pos) {
-  return word.at(pos) != letter && word.find(letter) != std::string::npos;
+std::string pattern_to_string(int pattern) {
+  return kPatternStrings.at(pattern).data();
 }
 
-bool does_not_have_letter(const std::string& word, const char letter, int pos) {
-  return word.find(letter) == std::string::npos;
+bool partitions_cover(const int* counts, int n) {
+  return std::accumulate(counts, counts + 243, 0) == n;
 }
 
-double calc_entropy_for_word(std::string query, const std::vector<std::string>& all_words, const std::vector<int>& constrained_word_idxs) {
-  std::vector<std::function<bool(const std::string&, const char, int)>> fs;
-
-  // has_letter_at_pos
-  fs.push_back(has_letter_at_pos);
-  fs.push_back(has_letter_not_at_pos);
-  fs.push_back(does_not_have_letter);
-
-  // TODO: this next section is the most wasteful - the inner loop can be the outer loop and we don't have to repeat it 243 times.
-  std::vector<double> counts;
-  for (const auto& [f0,f1,f2,f3,f4] : iter::product(fs,fs,fs,fs,fs)) {
-    int count = 0;
-    for (const auto idx : constrained_word_idxs) {
-      const auto& word = all_words.at(idx);
-      if (f0(word, query.at(0), 0) &&
-	  f1(word, query.at(1), 1) &&
-	  f2(word, query.at(2), 2) &&
-	  f3(word, query.at(3), 3) &&
-	  f4(word, query.at(4), 4)) {
-	count++;
-      }
+std::pair<int, int> max_bucket_from_patterns(const uint8_t* pattern_row, const std::vector<int>& constrained_sol_idxs) {
+  uint16_t counts[243] = {0};
+  for (const auto idx : constrained_sol_idxs) {
+    counts[pattern_row[idx]]++;
+  }
+  int best = 242;
+  for (int p = 241; p >= 0; --p) {
+    if (counts[p] > counts[best]) {
+      best = p;
     }
-    counts.push_back(count);
   }
-  std::for_each(counts.begin(), counts.end(), [&](double &c) { c /= constrained_word_idxs.size();});
-  return entropy(counts);
+  return std::make_pair(best, (int)counts[best]);
+}
+
+std::pair<std::string, int> parse_feedback(const std::string& constraints_string) {
+  std::string guess;
+  int pattern = 0;
+  for (int i = 0; i + 1 < constraints_string.size(); i+= 2) {
+    guess.push_back(constraints_string.at(i));
+    const char digit = constraints_string.at(i+1);
+    if (digit < '1' || digit > '3') {
+      return std::make_pair(guess, -1);
+    }
+    pattern = pattern * 3 + (digit - '1');
+  }
+  return std::make_pair(guess, pattern);
+}
+
+int string_to_pattern(const std::string& colours) {
+  if (colours.size() != 5) {
+    return -1;
+  }
+  static constexpr char kColours[] = "GYB";
+  int pattern = 0;
+  for (char c : colours) {
+    const char* colour = std::strchr(kColours, std::toupper((unsigned char)c));
+    if (c == '\0' || colour == nullptr) {
+      return -1;
+    }
+    pattern = pattern * 3 + (colour - kColours);
+  }
+  return pattern;
+}
+
+bool read_feedback(std::istream& in, std::string* guess, int* pattern) {
+  std::string word;
+  if (!(in >> word)) {
+    return false;
+  }
+  // the word lists are lowercase. the <cctype> functions take unsigned chars, and typed text may
+  // not be ascii.
+  std::transform(word.begin(), word.end(), word.begin(), [](unsigned char c) { return std::tolower(c); });
+  if (std::any_of(word.begin(), word.end(), [](unsigned char c) { return std::isdigit(c); })) {
+    std::tie(*guess, *pattern) = parse_feedback(word);
+    return true;
+  }
+  std::string colours;
+  if (!(in >> colours)) {
+    return false;
+  }
+  *guess = word;
+  *pattern = string_to_pattern(colours);
+  return true;
+}
+
+std::vector<uint8_t> build_pattern_table(const std::vector<std::string>& guess_words, const std::vector<std::string>& sol_words) {
+  return build_pattern_table_n<5>(guess_words, sol_words);
+}
+
+void calc_pattern_counts(const std::string& query, const std::vector<std::string>& all_words, const std::vector<int>& constrained_word_idxs, int* counts) {
+  std::fill(counts, counts + 243, 0);
+  for (const auto idx : constrained_word_idxs) {
+    counts[calc_pattern(query, all_words[idx])]++;
+  }
+  assert(partitions_cover(counts, constrained_word_idxs.size()));
+}
+
+void calc_pattern_counts_from_patterns(const uint8_t* pattern_row, const std::vector<int>& constrained_sol_idxs, int* counts) {
+  calc_pattern_counts_n<5>(pattern_row, constrained_sol_idxs, counts);
+}
+
+double calc_entropy_from_patterns(const uint8_t* pattern_row, const std::vector<int>& constrained_sol_idxs) {
+  int counts[243];
+  calc_pattern_counts_from_patterns(pattern_row, constrained_sol_idxs, counts);
+  return entropy_of_counts(counts, constrained_sol_idxs.size());
+}
+
+double calc_entropy_for_word(std::string query, const std::vector<std::string>& all_words, const std::vector<int>& constrained_word_idxs) {
+  // one pass computing each word's pattern; every word lands in exactly one of the 243.
+  int counts[243];
+  calc_pattern_counts(query, all_words, constrained_word_idxs, counts);
+  return entropy_of_counts(counts, constrained_word_idxs.size());
 }
 
 std::pair<std::string, double> get_best_word(const std::vector<std::string>& guess_words, const std::vector<int>& constrained_guess_idxs, const std::vector<std::string>& sol_words, const std::vector<int>& constrained_sol_idxs, bool use_cache) {
@@ -129,7 +227,18 @@ std::pair<std::string, double> get_best_word(const std::vector<std::string>& gue
     entrop_dict = load_checkpoint();
   }
 
+  // filling the checkpoint from scratch is the one sweep here long enough to want progress.
+  std::unique_ptr<ProgressReporter> progress;
+  if (use_cache) {
+    int num_missing = std::count_if(constrained_guess_idxs.begin(), constrained_guess_idxs.end(), [&](int idx) {
+      return entrop_dict.find(guess_words.at(idx)) == entrop_dict.end(); });
+    if (num_missing > 0) {
+      progress = std::make_unique<ProgressReporter>("checkpoint sweep", num_missing);
+    }
+  }
+
   int count = 0;
+  bool computed_any = false;
   for (const auto idx : constrained_guess_idxs) {
     const auto& query = guess_words.at(idx);
     if (entrop_dict.find(query) != entrop_dict.end()) {
@@ -137,16 +246,19 @@ std::pair<std::string, double> get_best_word(const std::vector<std::string>& gue
       continue;
     }
     entrop_dict[query] = calc_entropy_for_word(query, sol_words, constrained_sol_idxs);
+    computed_any = true;
     // std::cout << "entropy for " << query << " is " << entrop_dict.at(query) << std::endl;
     count++;
     // std::cout << query << " has entropy: " << entrop_dict[query] << std::endl;
+    if (progress) {
+      progress->add();
+    }
     if (use_cache && count % 20 == 0) {
-      std::cout << "saving checkpoint at " << count << " words" << std::endl;
       save_checkpoint(entrop_dict);
     }
   }
 
-  if (use_cache) {
+  if (use_cache && computed_any) {
     save_checkpoint(entrop_dict);
   }
 
@@ -158,32 +270,14 @@ std::pair<std::string, double> get_best_word(const std::vector<std::string>& gue
 
 // like calc_entropy_for_word but actually returns the partitions of words
 std::vector<std::vector<int>> partition_space_for_word(std::string query, const std::vector<std::string>& all_words, const std::vector<int>& remaining_words) {
-  std::vector<std::function<bool(const std::string&, const char, int)>> fs;
-
-  // has_letter_at_pos
-  fs.push_back(has_letter_at_pos);
-  fs.push_back(has_letter_not_at_pos);
-  fs.push_back(does_not_have_letter);
-
-  std::vector<std::vector<int>> partitions;
-  for (const auto& [f0,f1,f2,f3,f4] : iter::product(fs,fs,fs,fs,fs)) {
-    std::vector<int> part;
-    for (int idx : remaining_words) {
-      const auto& word = all_words.at(idx);
-      if (f0(word, query.at(0), 0) &&
-	  f1(word, query.at(1), 1) &&
-	  f2(word, query.at(2), 2) &&
-	  f3(word, query.at(3), 3) &&
-	  f4(word, query.at(4), 4)) {
-	part.push_back(idx);
-      }
-    }
-    partitions.push_back(part);
+  std::vector<std::vector<int>> partitions(243);
+  int counts[243];
+  for (int idx : remaining_words) {
+    partitions[calc_pattern(query, all_words[idx])].push_back(idx);
+  }
+  for (int p = 0; p < 243; ++p) {
+    counts[p] = partitions[p].size();
   }
-  // look at the partition
-  // for (const auto& part : partitions) {
-  //   std::cout << part.size() << ",";
-  // }
-  // std::cout << std::endl;
+  assert(partitions_cover(counts, remaining_words.size()));
   return partitions;
 }
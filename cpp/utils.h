@@ -1,15 +1,26 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <istream>
 #include <vector>
 #include <string>
 #include <map>
 
-#include "cppitertools/product.hpp"
+#include "word_length.h"
 
-// load 5-letter words from sowpods.txt
-std::vector<std::string> load_guess_words();
+// load 5-letter (or word_length-letter) words from sowpods.txt
+std::vector<std::string> load_guess_words(int word_length = 5);
 
-std::vector<std::string> load_sol_words();
+std::vector<std::string> load_sol_words(int word_length = 5);
+
+// read word lists and the checkpoint from the text files even when they're compiled in
+// (-DWORDLE_EMBEDDED) or packed in words.dict. every tool takes --word-files for this.
+void use_word_files();
 
 // load short corpus of 12 5-letter words.
 std::vector<std::string> load_words_test();
@@ -18,11 +29,76 @@ std::map<std::string, double> load_checkpoint();
 
 void save_checkpoint(const std::map<std::string, double>& entrop_dict);
 
-bool has_letter_at_pos(const std::string& word, const char letter, int pos);
+// pattern of query against word: the index of the partition word falls in, in the order
+// partition_space_for_word returns them. base 3, one digit per position with position 0 the
+// most significant: 0 = letter in the right spot, 1 = in the word but not there, 2 = not in the word.
+// 0 is all green (word == query), 242 is all grey. a letter query repeats is only yellow as
+// many times as word has spare copies of it (see calc_pattern_n).
+int calc_pattern(const std::string& query, const std::string& word);
+
+// kPatternStrings[pattern] is pattern spelled out in G(reen)/Y(ellow)/B(lack), e.g. 0 -> GGGGG.
+constexpr std::array<std::array<char, 6>, 243> make_pattern_strings() {
+  std::array<std::array<char, 6>, 243> table = {};
+  for (int pattern = 0; pattern < 243; ++pattern) {
+    for (int pos = 0; pos < 5; ++pos) {
+      table[pattern][pos] = "GYB"[pattern / kPow3[4 - pos] % 3];
+    }
+  }
+  return table;
+}
+
+inline constexpr auto kPatternStrings = make_pattern_strings();
+
+// pattern -> string of G(reen)/Y(ellow)/B(lack), e.g. 0 -> GGGGG, 242 -> BBBBB.
+std::string pattern_to_string(int pattern);
+
+// true if counts (a histogram over the 243 patterns) accounts for exactly n words: every
+// word landed in exactly one partition.
+bool partitions_cover(const int* counts, int n);
+
+// the largest partition of the constrained solutions for one row of the pattern table, as
+// (pattern, size), counted without building the partitions. ties go to the higher pattern,
+// i.e. the one with the fewest greens and yellows at the front.
+std::pair<int, int> max_bucket_from_patterns(const uint8_t* pattern_row, const std::vector<int>& constrained_sol_idxs);
+
+// the guess and its pattern spelled out by a constraint string like t1e2a2r3s3 (letter, then
+// 1 = right spot, 2 = wrong spot, 3 = not in the word). the pattern is -1 if a digit isn't one of those.
+std::pair<std::string, int> parse_feedback(const std::string& constraints_string);
+
+// the inverse of pattern_to_string (either case), or -1 if colours isn't five of G/Y/B.
+int string_to_pattern(const std::string& colours);
+
+// reads one guess's feedback from in, either as a constraint string or as the guess and the
+// colours the game showed (soare BYBBG). false at the end of input; the pattern is -1 if what
+// was typed isn't either.
+bool read_feedback(std::istream& in, std::string* guess, int* pattern);
+
+// pattern of every guess word against every solution word, row-major by guess:
+// table[guess_idx * sol_words.size() + sol_idx].
+std::vector<uint8_t> build_pattern_table(const std::vector<std::string>& guess_words, const std::vector<std::string>& sol_words);
+
+// histogram of the patterns query makes against the constrained words: counts[pattern] for all
+// 243 patterns. this is the one pass over the solutions that every scoring policy reduces.
+void calc_pattern_counts(const std::string& query, const std::vector<std::string>& all_words, const std::vector<int>& constrained_word_idxs, int* counts);
+
+// same, reading the patterns from a row of the pattern table.
+void calc_pattern_counts_from_patterns(const uint8_t* pattern_row, const std::vector<int>& constrained_sol_idxs, int* counts);
 
-bool has_letter_not_at_pos(const std::string& word, const char letter, int pos);
+// entropy of a pattern histogram with n words in total. num_patterns is 3^word length.
+inline double entropy_of_counts(const int* counts, int n, int num_patterns = 243) {
+  double ent = 0.0;
+  for (int i = 0; i < num_patterns; ++i) {
+    if (counts[i] == 0) {
+      continue;
+    }
+    double prob = (double)counts[i] / n;
+    ent += prob * log2(prob);
+  }
+  return -1.0 * ent;
+}
 
-bool does_not_have_letter(const std::string& word, const char letter, int pos);
+// like calc_entropy_for_word, but reads the patterns from a row of the pattern table.
+double calc_entropy_from_patterns(const uint8_t* pattern_row, const std::vector<int>& constrained_sol_idxs);
 
 // given the query word and the list of possible solutions, return the entropy.
 double calc_entropy_for_word(std::string query, const std::vector<std::string>& all_solutions, const std::vector<int>& constrained_solution_idxs);
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// the engine templated on word length N. wordle itself is N = 5, and the 5-letter functions in
+// utils.h are this code instantiated for 5; other lengths (4 to 8) run on the same code.
+
+constexpr int pow3(int n) {
+  return n == 0 ? 1 : 3 * pow3(n - 1);
+}
+
+constexpr int kMinWordLength = 4;
+constexpr int kMaxWordLength = 8;
+
+// kPow3[i] = 3^i: the weight of a digit i places from the end of a pattern.
+constexpr std::array<int, kMaxWordLength + 1> make_pow3_table() {
+  std::array<int, kMaxWordLength + 1> table = {};
+  for (int i = 0; i <= kMaxWordLength; ++i) {
+    table[i] = pow3(i);
+  }
+  return table;
+}
+
+inline constexpr auto kPow3 = make_pow3_table();
+
+template <int N>
+struct WordTraits {
+  static_assert(N >= 1 && N <= kMaxWordLength, "unsupported word length");
+  static constexpr int kLength = N;
+  // number of distinct feedbacks, 3^N.
+  static constexpr int kNumPatterns = pow3(N);
+  // smallest type that holds a pattern: 243 patterns fit in a byte, 729 and up don't.
+  using pattern_t = std::conditional_t<(kNumPatterns <= 256), uint8_t, uint16_t>;
+};
+
+// see calc_pattern in utils.h for the encoding. this is the one place feedback is computed;
+// everything else (tables, histograms, filters, hard mode) calls it. repeated letters score like
+// the game: greens are matched first, then each other copy of a letter in query is yellow while
+// word still has an unmatched copy of it, left to right, and grey once they run out. N is a
+// compile-time constant so both loops unroll completely and the digits are computed without
+// branches.
+template <int N>
+inline typename WordTraits<N>::pattern_t calc_pattern_n(const char* query, const char* word) {
+  // copies of each letter of word not taken by a green, indexed by the low 5 bits of the letter.
+  uint8_t unmatched[32] = {};
+  bool green[N];
+  for (int pos = 0; pos < N; ++pos) {
+    green[pos] = query[pos] == word[pos];
+    unmatched[word[pos] & 31] += !green[pos];
+  }
+  int pattern = 0;
+  for (int pos = 0; pos < N; ++pos) {
+    uint8_t& left = unmatched[query[pos] & 31];
+    const int yellow = !green[pos] & (left > 0);
+    left -= yellow;
+    pattern += !green[pos] * (2 - yellow) * kPow3[N - 1 - pos];
+  }
+  return pattern;
+}
+
+// calc_pattern_n for a length only known at run time.
+inline int calc_pattern_any_length(const std::string& query, const std::string& word) {
+  switch (query.size()) {
+  case 4: return calc_pattern_n<4>(query.data(), word.data());
+  case 5: return calc_pattern_n<5>(query.data(), word.data());
+  case 6: return calc_pattern_n<6>(query.data(), word.data());
+  case 7: return calc_pattern_n<7>(query.data(), word.data());
+  case 8: return calc_pattern_n<8>(query.data(), word.data());
+  }
+  return -1;
+}
+
+// row-major guess x solution table, like build_pattern_table.
+template <int N>
+std::vector<typename WordTraits<N>::pattern_t> build_pattern_table_n(const std::vector<std::string>& guess_words, const std::vector<std::string>& sol_words) {
+  std::vector<typename WordTraits<N>::pattern_t> table(guess_words.size() * sol_words.size());
+  for (size_t g = 0; g < guess_words.size(); ++g) {
+    auto* row = table.data() + g * sol_words.size();
+    for (size_t s = 0; s < sol_words.size(); ++s) {
+      row[s] = calc_pattern_n<N>(guess_words[g].data(), sol_words[s].data());
+    }
+  }
+  return table;
+}
+
+// histogram of one row of the table over the constrained solutions; counts has kNumPatterns entries.
+template <int N>
+void calc_pattern_counts_n(const typename WordTraits<N>::pattern_t* pattern_row, const std::vector<int>& constrained_sol_idxs, int* counts) {
+  std::fill(counts, counts + WordTraits<N>::kNumPatterns, 0);
+  for (const auto idx : constrained_sol_idxs) {
+    counts[pattern_row[idx]]++;
+  }
+}
+
+// every word in filename, bucketed by length in one streaming pass: words.at(len).
+// lengths above kMaxWordLength are dropped.
+std::vector<std::vector<std::string>> load_words_by_length(const std::string& filename);
+
+// the word_length-letter words in filename, from the binary dictionary (see dictionary.h) if
+// build_dict has packed it.
+std::vector<std::string> load_words_of_length(const std::string& filename, int word_length);
@@ -0,0 +1,215 @@
+#include "wordle_c.h"
+#include "wordle_core.h"
+
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <unordered_map>
+
+struct wordle_dictionary {
+  Dictionary dictionary;
+};
+
+struct wordle_session {
+  Session session;
+};
+
+namespace {
+
+bool policy_from_name(const char* name, ScoringPolicy* policy) {
+  *policy = ScoringPolicy::kEntropy;
+  return name == nullptr || parse_scoring_policy(name, policy);
+}
+
+int copy_word(const std::string& word, char* out, int out_size) {
+  if (out == nullptr || out_size <= (int)word.size()) {
+    return WORDLE_ERR_BUFFER;
+  }
+  std::memcpy(out, word.c_str(), word.size() + 1);
+  return word.size();
+}
+
+// guesses session takes to find sol, like simulate plays it. the choice only depends on the
+// feedback so far, so games that share a prefix of it look the guess up in choices.
+int play(Session& session, const Dictionary& dictionary, ScoringPolicy policy, int opener, int sol, std::unordered_map<std::string, int>& choices) {
+  session.reset();
+  std::string feedback;
+  for (int guesses_made = 0;; ++guesses_made) {
+    const std::vector<int>& candidates = session.candidates();
+    if (candidates.size() == 1) {
+      return guesses_made + 1;
+    }
+    int guess = opener;
+    if (guesses_made > 0) {
+      auto [it, inserted] = choices.emplace(feedback, -1);
+      if (inserted) {
+	it->second = session.best_guess(policy).first;
+      }
+      guess = it->second;
+    }
+    int pattern = dictionary.pattern(guess, sol);
+    if (pattern == 0) {
+      return guesses_made + 1;
+    }
+    bool splits = false;
+    for (int s : candidates) {
+      splits = splits || dictionary.pattern(guess, s) != pattern;
+    }
+    if (!splits) {
+      // the policy picked a guess that can't tell any of them apart. just guess them in turn.
+      return guesses_made + 1 + (std::lower_bound(candidates.begin(), candidates.end(), sol) - candidates.begin());
+    }
+    session.apply_feedback(guess, pattern);
+    feedback.push_back(pattern);
+  }
+}
+
+}  // namespace
+
+extern "C" {
+
+int wordle_abi_version(void) {
+  return WORDLE_ABI_VERSION;
+}
+
+wordle_dictionary* wordle_dictionary_load(const char* guess_file, const char* sol_file, int with_table) {
+  // nothing may throw across the C boundary; the only thing that can here is running out of memory.
+  try {
+    std::vector<std::string> guess_words = load_words_of_length(guess_file ? guess_file : "sowpods.txt", 5);
+    std::vector<std::string> sol_words = load_words_of_length(sol_file ? sol_file : "solutions.txt", 5);
+    if (guess_words.empty() || sol_words.empty()) {
+      return nullptr;
+    }
+    Dictionary::Options options;
+    options.with_table = with_table != 0;
+    return new wordle_dictionary{Dictionary(std::move(guess_words), std::move(sol_words), options)};
+  } catch (const std::exception&) {
+    return nullptr;
+  }
+}
+
+void wordle_dictionary_free(wordle_dictionary* dictionary) {
+  delete dictionary;
+}
+
+int wordle_dictionary_num_guesses(const wordle_dictionary* dictionary) {
+  return dictionary->dictionary.num_guesses();
+}
+
+int wordle_dictionary_num_solutions(const wordle_dictionary* dictionary) {
+  return dictionary->dictionary.num_sols();
+}
+
+int wordle_dictionary_guess_word(const wordle_dictionary* dictionary, int guess, char* out, int out_size) {
+  if (guess < 0 || guess >= dictionary->dictionary.num_guesses()) {
+    return WORDLE_ERR_ARGUMENT;
+  }
+  return copy_word(dictionary->dictionary.guess_words()[guess], out, out_size);
+}
+
+int wordle_dictionary_solution_word(const wordle_dictionary* dictionary, int sol, char* out, int out_size) {
+  if (sol < 0 || sol >= dictionary->dictionary.num_sols()) {
+    return WORDLE_ERR_ARGUMENT;
+  }
+  return copy_word(dictionary->dictionary.sol_words()[sol], out, out_size);
+}
+
+int wordle_dictionary_find_guess(const wordle_dictionary* dictionary, const char* word) {
+  return word ? dictionary->dictionary.find_guess(word) : WORDLE_ERR_ARGUMENT;
+}
+
+int wordle_dictionary_find_solution(const wordle_dictionary* dictionary, const char* word) {
+  return word ? dictionary->dictionary.find_sol(word) : WORDLE_ERR_ARGUMENT;
+}
+
+int wordle_pattern(const wordle_dictionary* dictionary, int guess, int sol) {
+  if (guess < 0 || guess >= dictionary->dictionary.num_guesses() || sol < 0 || sol >= dictionary->dictionary.num_sols()) {
+    return WORDLE_ERR_ARGUMENT;
+  }
+  return dictionary->dictionary.pattern(guess, sol);
+}
+
+wordle_session* wordle_session_new(const wordle_dictionary* dictionary, int hard_mode) {
+  try {
+    return new wordle_session{Session(dictionary->dictionary, hard_mode != 0)};
+  } catch (const std::exception&) {
+    return nullptr;
+  }
+}
+
+void wordle_session_free(wordle_session* session) {
+  delete session;
+}
+
+void wordle_session_reset(wordle_session* session) {
+  session->session.reset();
+}
+
+int wordle_session_apply_feedback(wordle_session* session, const char* guess, int pattern) {
+  if (guess == nullptr || !session->session.apply_feedback(guess, pattern)) {
+    return WORDLE_ERR_ARGUMENT;
+  }
+  return 0;
+}
+
+int wordle_session_num_candidates(const wordle_session* session) {
+  return session->session.candidates().size();
+}
+
+int wordle_session_candidates(const wordle_session* session, int* out, int capacity) {
+  const std::vector<int>& candidates = session->session.candidates();
+  if (out != nullptr) {
+    std::copy_n(candidates.begin(), std::min<int>(capacity, candidates.size()), out);
+  }
+  return candidates.size();
+}
+
+int wordle_session_rank(wordle_session* session, const char* policy, int k, int* guesses, double* scores) {
+  ScoringPolicy scoring_policy;
+  if (!policy_from_name(policy, &scoring_policy)) {
+    return WORDLE_ERR_POLICY;
+  }
+  if (k < 0 || (k > 0 && (guesses == nullptr || scores == nullptr))) {
+    return WORDLE_ERR_ARGUMENT;
+  }
+  try {
+    // the scores go through the session's scratch buffers; the list they're copied out of is
+    // kept per thread, so it only allocates on a thread's first call.
+    thread_local std::vector<std::pair<int, double>> ranked;
+    session->session.rank(scoring_policy, k, &ranked);
+    for (int i = 0; i < ranked.size(); ++i) {
+      guesses[i] = ranked[i].first;
+      scores[i] = ranked[i].second;
+    }
+    return ranked.size();
+  } catch (const std::exception&) {
+    return WORDLE_ERR_INTERNAL;
+  }
+}
+
+int wordle_simulate(const wordle_dictionary* dictionary, const char* policy, int hard_mode, const char* opener, int* guess_counts, int capacity) {
+  const Dictionary& dict = dictionary->dictionary;
+  ScoringPolicy scoring_policy;
+  if (!policy_from_name(policy, &scoring_policy)) {
+    return WORDLE_ERR_POLICY;
+  }
+  if (guess_counts == nullptr || capacity < dict.num_sols()) {
+    return WORDLE_ERR_BUFFER;
+  }
+  try {
+    Session session(dict, hard_mode != 0);
+    int opener_idx = opener ? dict.find_guess(opener) : session.best_guess(scoring_policy).first;
+    if (opener_idx < 0) {
+      return WORDLE_ERR_ARGUMENT;
+    }
+    std::unordered_map<std::string, int> choices;
+    for (int sol = 0; sol < dict.num_sols(); ++sol) {
+      guess_counts[sol] = play(session, dict, scoring_policy, opener_idx, sol, choices);
+    }
+    return dict.num_sols();
+  } catch (const std::exception&) {
+    return WORDLE_ERR_INTERNAL;
+  }
+}
+
+}  // extern "C"
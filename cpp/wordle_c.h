@@ -0,0 +1,73 @@
+#ifndef WORDLE_C_H
+#define WORDLE_C_H
+
+/* a C interface to wordle_core.h, built as libwordle.so so other languages (solve_wordle.py,
+ * through ctypes) can call the solver. everything goes through opaque handles, and anything
+ * that returns more than a number writes into buffers the caller owns, so nothing allocated in
+ * here ever has to be freed on the other side. functions that can fail return a negative
+ * WORDLE_ERR_* code (or NULL for handles) instead of throwing.
+ *
+ * a dictionary can be shared by any number of sessions, from any number of threads; a session
+ * belongs to one thread at a time. patterns are base 3 with the first letter most significant:
+ * 0 green, 1 yellow, 2 grey, so 0 means solved. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* bumped whenever a signature below changes. */
+#define WORDLE_ABI_VERSION 1
+
+#define WORDLE_ERR_ARGUMENT -1
+#define WORDLE_ERR_POLICY -2
+#define WORDLE_ERR_BUFFER -3
+#define WORDLE_ERR_INTERNAL -4
+
+typedef struct wordle_dictionary wordle_dictionary;
+typedef struct wordle_session wordle_session;
+
+int wordle_abi_version(void);
+
+/* 5-letter words from guess_file and sol_file (NULL for sowpods.txt and solutions.txt), read
+ * like the tools do (compiled in, words.dict or the text file). with_table builds the guess x
+ * solution pattern table (~30 MB for the default lists), which makes ranking and simulating
+ * several times faster. NULL if either list comes out empty. */
+wordle_dictionary* wordle_dictionary_load(const char* guess_file, const char* sol_file, int with_table);
+void wordle_dictionary_free(wordle_dictionary* dictionary);
+
+int wordle_dictionary_num_guesses(const wordle_dictionary* dictionary);
+int wordle_dictionary_num_solutions(const wordle_dictionary* dictionary);
+/* writes the word and a terminating 0 to out (at least 6 bytes). */
+int wordle_dictionary_guess_word(const wordle_dictionary* dictionary, int guess, char* out, int out_size);
+int wordle_dictionary_solution_word(const wordle_dictionary* dictionary, int sol, char* out, int out_size);
+/* index of word, or -1. */
+int wordle_dictionary_find_guess(const wordle_dictionary* dictionary, const char* word);
+int wordle_dictionary_find_solution(const wordle_dictionary* dictionary, const char* word);
+/* the pattern guessing guess makes when the answer is sol. */
+int wordle_pattern(const wordle_dictionary* dictionary, int guess, int sol);
+
+/* a game on dictionary, which has to outlive it. */
+wordle_session* wordle_session_new(const wordle_dictionary* dictionary, int hard_mode);
+void wordle_session_free(wordle_session* session);
+void wordle_session_reset(wordle_session* session);
+
+/* narrows the game down with the feedback for guess, which doesn't have to be in the guess list. */
+int wordle_session_apply_feedback(wordle_session* session, const char* guess, int pattern);
+int wordle_session_num_candidates(const wordle_session* session);
+/* up to capacity candidate solution indices, ascending; returns how many there are in total. */
+int wordle_session_candidates(const wordle_session* session, int* out, int capacity);
+
+/* the k best guesses for the game so far under policy (a name simulate --policy takes, NULL for
+ * entropy), best first, as guess indices and scores. returns how many were written, or
+ * WORDLE_ERR_INTERNAL if it ran out of memory. */
+int wordle_session_rank(wordle_session* session, const char* policy, int k, int* guesses, double* scores);
+
+/* plays every solution with policy, opening with opener (NULL to pick one), and writes how many
+ * guesses each took to guess_counts (num_solutions ints). returns the number of games. */
+int wordle_simulate(const wordle_dictionary* dictionary, const char* policy, int hard_mode, const char* opener, int* guess_counts, int capacity);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
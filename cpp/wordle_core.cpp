@@ -0,0 +1,137 @@
+#include "wordle_core.h"
+
+#include <algorithm>
+#include <numeric>
+
+// a game rarely goes past this many guesses; more still works, it just allocates.
+constexpr int kReservedHistory = 32;
+
+std::unique_ptr<const Dictionary> Dictionary::load(const Options& options) {
+  return std::make_unique<const Dictionary>(load_guess_words(), load_sol_words(), options);
+}
+
+Dictionary::Dictionary(std::vector<std::string> guess_words, std::vector<std::string> sol_words, const Options& options)
+  : guess_words_(std::move(guess_words)), sol_words_(std::move(sol_words)), guesses_sorted_(std::is_sorted(guess_words_.begin(), guess_words_.end())) {
+  if (options.with_table) {
+    table_ = std::make_unique<PatternTable>(options.table_dir.empty() ? PatternTable::build(guess_words_, sol_words_) : PatternTable::open_shared(options.table_dir, guess_words_, sol_words_));
+  }
+}
+
+int Dictionary::find_guess(const std::string& word) const {
+  // sowpods.txt is sorted, so this is a binary search unless someone passed other lists.
+  auto it = guesses_sorted_ ? std::lower_bound(guess_words_.begin(), guess_words_.end(), word) : std::find(guess_words_.begin(), guess_words_.end(), word);
+  return it != guess_words_.end() && *it == word ? it - guess_words_.begin() : -1;
+}
+
+int Dictionary::find_sol(const std::string& word) const {
+  auto it = std::find(sol_words_.begin(), sol_words_.end(), word);
+  return it == sol_words_.end() ? -1 : it - sol_words_.begin();
+}
+
+Session::Session(const Dictionary& dictionary, bool hard_mode)
+  : dictionary_(&dictionary), hard_mode_(hard_mode), counts_(243) {
+  candidates_.reserve(dictionary.num_sols());
+  allowed_.reserve(dictionary.num_guesses());
+  history_.reserve(kReservedHistory);
+  scores_.reserve(dictionary.num_guesses());
+  order_.reserve(dictionary.num_guesses());
+  reset();
+}
+
+void Session::reset() {
+  const int num_sols = dictionary_->num_sols();
+  candidates_.resize(num_sols);
+  std::iota(candidates_.begin(), candidates_.end(), 0);
+  allowed_.resize(dictionary_->num_guesses());
+  std::iota(allowed_.begin(), allowed_.end(), 0);
+  history_.clear();
+}
+
+bool Session::apply_feedback(const std::string& guess, int pattern) {
+  if (guess.size() != 5 || pattern < 0 || pattern >= 243) {
+    return false;
+  }
+  keep_candidates_where(pattern, guess, dictionary_->patterns() ? dictionary_->find_guess(guess) : -1);
+  if (hard_mode_) {
+    keep_allowed_where(pattern, guess);
+  }
+  history_.push_back({guess, pattern});
+  return true;
+}
+
+void Session::apply_feedback(int guess_idx, int pattern) {
+  const std::string& guess = dictionary_->guess_words()[guess_idx];
+  keep_candidates_where(pattern, guess, guess_idx);
+  if (hard_mode_) {
+    keep_allowed_where(pattern, guess);
+  }
+  history_.push_back({guess, pattern});
+}
+
+void Session::keep_candidates_where(int pattern, const std::string& guess, int guess_idx) {
+  // in place: the kept candidates are a prefix of the old ones, still ascending.
+  const uint8_t* row = guess_idx >= 0 && dictionary_->patterns() ? dictionary_->patterns() + (size_t)guess_idx * dictionary_->num_sols() : nullptr;
+  int kept = 0;
+  for (int s : candidates_) {
+    if ((row ? row[s] : calc_pattern(guess, dictionary_->sol_words()[s])) == pattern) {
+      candidates_[kept++] = s;
+    }
+  }
+  candidates_.resize(kept);
+}
+
+void Session::keep_allowed_where(int pattern, const std::string& guess) {
+  // h stays allowed iff it would have been a possible answer, like HardModeGuesses.
+  const auto& guess_words = dictionary_->guess_words();
+  int kept = 0;
+  for (int h : allowed_) {
+    if (calc_pattern(guess, guess_words[h]) == pattern) {
+      allowed_[kept++] = h;
+    }
+  }
+  allowed_.resize(kept);
+}
+
+void Session::score_allowed(ScoringPolicy policy) {
+  scores_.resize(allowed_.size());
+  dispatch_scoring_policy(policy, [&](auto p) {
+    using Policy = decltype(p);
+    const uint8_t* table = dictionary_->patterns();
+    const int num_sols = dictionary_->num_sols();
+    for (int i = 0; i < allowed_.size(); ++i) {
+      const int g = allowed_[i];
+      if (table) {
+	calc_pattern_counts_n<5>(table + (size_t)g * num_sols, candidates_, counts_.data());
+      } else {
+	calc_pattern_counts(dictionary_->guess_words()[g], dictionary_->sol_words(), candidates_, counts_.data());
+      }
+      scores_[i] = Policy::template score<243>(counts_.data(), candidates_.size());
+    }
+    return 0;
+  });
+}
+
+std::pair<int, double> Session::best_guess(ScoringPolicy policy) {
+  score_allowed(policy);
+  int best = 0;
+  for (int i = 1; i < allowed_.size(); ++i) {
+    if (scores_[i] > scores_[best]) {
+      best = i;
+    }
+  }
+  return allowed_.empty() ? std::make_pair(-1, 0.0) : std::make_pair(allowed_[best], scores_[best]);
+}
+
+void Session::rank(ScoringPolicy policy, int k, std::vector<std::pair<int, double>>* ranked) {
+  score_allowed(policy);
+  k = std::min<int>(k, allowed_.size());
+  order_.resize(allowed_.size());
+  std::iota(order_.begin(), order_.end(), 0);
+  // allowed_ is ascending, so breaking ties on position breaks them on index.
+  std::partial_sort(order_.begin(), order_.begin() + k, order_.end(), [&](int a, int b) {
+    return scores_[a] > scores_[b] || (scores_[a] == scores_[b] && a < b); });
+  ranked->clear();
+  for (int i = 0; i < k; ++i) {
+    ranked->emplace_back(allowed_[order_[i]], scores_[order_[i]]);
+  }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "scoring.h"
+#include "shared_table.h"
+#include "utils.h"
+
+// the solver as a library: a Dictionary holds everything that doesn't change during a game
+// (the word lists and, optionally, the guess x solution pattern table), and a Session holds
+// one game's state on top of it: the candidates left (an ascending index list),
+// the guesses still allowed in hard mode, the feedback so far and scratch space for scoring.
+// sessions sized their buffers for the whole dictionary up front, so applying feedback,
+// picking and ranking guesses don't allocate once a game is under way.
+
+class Dictionary {
+ public:
+  struct Options {
+    bool with_table = false;
+    // share the table with other processes through this directory (see shared_table.h).
+    std::string table_dir;
+  };
+
+  // load_guess_words() and load_sol_words().
+  static std::unique_ptr<const Dictionary> load(const Options& options);
+  Dictionary(std::vector<std::string> guess_words, std::vector<std::string> sol_words, const Options& options);
+
+  const std::vector<std::string>& guess_words() const { return guess_words_; }
+  const std::vector<std::string>& sol_words() const { return sol_words_; }
+  int num_guesses() const { return guess_words_.size(); }
+  int num_sols() const { return sol_words_.size(); }
+
+  // the pattern table if there is one, else nullptr.
+  const uint8_t* patterns() const { return table_ ? table_->data() : nullptr; }
+  int pattern(int guess, int sol) const {
+    return table_ ? table_->data()[(size_t)guess * sol_words_.size() + sol] : calc_pattern(guess_words_[guess], sol_words_[sol]);
+  }
+
+  // index of word in the guess list, or -1.
+  int find_guess(const std::string& word) const;
+  int find_sol(const std::string& word) const;
+
+ private:
+  std::vector<std::string> guess_words_;
+  std::vector<std::string> sol_words_;
+  std::unique_ptr<PatternTable> table_;
+  bool guesses_sorted_;
+};
+
+class Session {
+ public:
+  Session(const Dictionary& dictionary, bool hard_mode);
+
+  // back to the start of a game.
+  void reset();
+
+  // narrows the candidates (and in hard mode the allowed guesses) to those consistent with
+  // pattern for guess, which doesn't have to be in the guess list. false if guess has the
+  // wrong length or pattern isn't one.
+  bool apply_feedback(const std::string& guess, int pattern);
+  void apply_feedback(int guess_idx, int pattern);
+
+  // indices into the solution list, ascending.
+  const std::vector<int>& candidates() const { return candidates_; }
+  // indices into the guess list, ascending: every guess unless in hard mode.
+  const std::vector<int>& allowed_guesses() const { return allowed_; }
+
+  struct Feedback {
+    std::string guess;
+    int pattern;
+  };
+  const std::vector<Feedback>& history() const { return history_; }
+
+  // the allowed guess with the highest score over the candidates, ties to the lowest index.
+  std::pair<int, double> best_guess(ScoringPolicy policy);
+
+  // the k best allowed guesses (index, score), best first, into ranked.
+  void rank(ScoringPolicy policy, int k, std::vector<std::pair<int, double>>* ranked);
+
+ private:
+  void keep_candidates_where(int pattern, const std::string& guess, int guess_idx);
+  void keep_allowed_where(int pattern, const std::string& guess);
+  // scores_[i] for allowed_[i].
+  void score_allowed(ScoringPolicy policy);
+
+  const Dictionary* dictionary_;
+  bool hard_mode_;
+  std::vector<int> candidates_;
+  std::vector<int> allowed_;
+  std::vector<Feedback> history_;
+  // scratch.
+  std::vector<int> counts_;
+  std::vector<double> scores_;
+  std::vector<int> order_;
+};
@@ -1,11 +1,11 @@
+import ctypes
+import os
 import string
 import pickle
 import sys
 
-from itertools import product
 from scipy.stats import entropy
 from os.path import exists
-from functools import partial
 
 def load_words():
     # with open('words_alpha.txt') as word_file:
@@ -14,50 +14,47 @@ def load_words():
 
     return valid_words
 
-def has_letter_at_pos(word, letter, pos):
-    return word[pos] == letter
-
-def has_letter_not_at_pos(word, letter, pos):
-    if has_letter_at_pos(word, letter, pos):
-        return False
-    return word.find(letter) != -1
-
-def does_not_have_letter(word, letter, pos):
-    return word.find(letter) == -1
+def feedback(guess, answer):
+    # the pattern id, like calc_pattern in the C++ version: base 3 with the first letter most
+    # significant, 0 green, 1 yellow, 2 grey. greens are matched first, then a repeated letter is
+    # only yellow while the answer has copies of it left over.
+    unmatched = {}
+    for g, a in zip(guess, answer):
+        if g != a:
+            unmatched[a] = unmatched.get(a, 0) + 1
+    pattern = 0
+    for g, a in zip(guess, answer):
+        digit = 0
+        if g != a:
+            digit = 2
+            if unmatched.get(g, 0) > 0:
+                unmatched[g] -= 1
+                digit = 1
+        pattern = pattern * 3 + digit
+    return pattern
 
 def calc_entropy_for_word(query, all_words):
-    # what are all the ways things could turn out?
-    # - 243 combinations
-    # - 12.5k words
-    # - 5 checks
-    # - thats ~ 15 million checks per word...
-    counts = []
-    for comb in product([has_letter_at_pos, has_letter_not_at_pos, does_not_have_letter], repeat=5):
-        count = 0
-        for word in all_words:
-            if all([comb[i](word, query[i], i) for i in range(5)]):
-                # print("found one!" + word)
-                count += 1
-        counts.append(count)
+    # every word lands in exactly one of the 243 patterns.
+    counts = [0] * 243
+    for word in all_words:
+        counts[feedback(query, word)] += 1
+    assert sum(counts) == len(all_words)
     probs = [float(count) / len(all_words) for count in counts]
-    # print(probs[0:10])
     return entropy(probs, base=2)
 
 def parse_constraints_string(constraints_string):
-    if len(constraints_string) == 0:
-        return []
-    constraints = []
-    constraint_order = [has_letter_at_pos, has_letter_not_at_pos, does_not_have_letter]
-    for i in range(0, len(constraints_string), 2):
-        letter = constraints_string[i]
-        idx = int(constraints_string[i+1])-1
-        constraints.append(partial(constraint_order[idx],letter=letter, pos=i/2))
-    return constraints
+    # t1e2a2r3s3 -> (guess, pattern id)
+    guess = constraints_string[0::2]
+    pattern = 0
+    for digit in constraints_string[1::2]:
+        pattern = pattern * 3 + int(digit) - 1
+    return (guess, pattern)
 
 def get_best_word(word_list, use_cache):
     entrop_dict = {}
-    if use_cache and exists('entrop.pickle'):
-        with open('entrop.pickle', 'rb') as handle:
+    # not entrop.pickle any more: that one was scored before repeated letters were.
+    if use_cache and exists('entropies.pickle'):
+        with open('entropies.pickle', 'rb') as handle:
             entrop_dict = pickle.load(handle)
             print("loading entropy from pickle with length: ", len(entrop_dict))
 
@@ -71,7 +68,7 @@ def get_best_word(word_list, use_cache):
         if use_cache and count % 20 == 0:
             print(query, " has entropy: ", entrop_dict[query])
             print("checkpointing entropy at count: ", count)
-            with open('entrop.pickle', 'wb') as handle:
+            with open('entropies.pickle', 'wb') as handle:
                 pickle.dump(entrop_dict, handle, protocol=pickle.HIGHEST_PROTOCOL)
         count += 1
 
@@ -79,7 +76,104 @@ def get_best_word(word_list, use_cache):
     entrop = entrop_dict[best_word]
     return (best_word, entrop)
 
+# the C++ solver through cpp/libwordle.so (see cpp/wordle_c.h), if it's been built. it ranks
+# every guess, not just the words still possible, so it can suggest a word that isn't the answer.
+def load_native():
+    here = os.path.dirname(os.path.abspath(__file__))
+    for path in [os.path.join(here, 'cpp', 'libwordle.so'), os.path.join(here, 'libwordle.so'), os.path.abspath('libwordle.so')]:
+        if not exists(path):
+            continue
+        lib = ctypes.CDLL(path)
+        if lib.wordle_abi_version() != 1:
+            print("ignoring " + path + ", it was built for a different version of this script")
+            continue
+        lib.wordle_dictionary_load.restype = ctypes.c_void_p
+        lib.wordle_dictionary_load.argtypes = [ctypes.c_char_p, ctypes.c_char_p, ctypes.c_int]
+        lib.wordle_dictionary_num_guesses.argtypes = [ctypes.c_void_p]
+        lib.wordle_dictionary_guess_word.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_char_p, ctypes.c_int]
+        lib.wordle_session_new.restype = ctypes.c_void_p
+        lib.wordle_session_new.argtypes = [ctypes.c_void_p, ctypes.c_int]
+        lib.wordle_session_apply_feedback.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int]
+        lib.wordle_session_num_candidates.argtypes = [ctypes.c_void_p]
+        lib.wordle_session_candidates.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_int), ctypes.c_int]
+        lib.wordle_session_rank.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int, ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_double)]
+        lib.wordle_dictionary_solution_word.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.c_char_p, ctypes.c_int]
+        return lib
+    return None
+
+class NativeSolver(object):
+    def __init__(self, lib):
+        self.lib = lib
+        # every 5-letter word can be the answer, like the pure python solver.
+        self.dictionary = lib.wordle_dictionary_load(b'sowpods.txt', b'sowpods.txt', 0)
+        if not self.dictionary:
+            raise IOError("can't load sowpods.txt")
+        self.session = lib.wordle_session_new(self.dictionary, 0)
+        self.word = ctypes.create_string_buffer(16)
+
+    def guess_word(self, idx):
+        self.lib.wordle_dictionary_guess_word(self.dictionary, idx, self.word, len(self.word))
+        return self.word.value.decode()
+
+    # a constraint string or, like the C++ solver, the guess and its colours (tares GBYYB).
+    def apply_constraints_string(self, constraints_string):
+        fields = constraints_string.split()
+        if len(fields) == 2 and len(fields[1]) == 5 and all(c in 'GYB' for c in fields[1].upper()):
+            guess = fields[0]
+            digits = [str('GYB'.index(c) + 1) for c in fields[1].upper()]
+        elif len(constraints_string) == 10 and all(digit in '123' for digit in constraints_string[1::2]):
+            guess = constraints_string[0::2]
+            digits = constraints_string[1::2]
+        else:
+            return False
+        pattern = 0
+        for digit in digits:
+            pattern = pattern * 3 + int(digit) - 1
+        return self.lib.wordle_session_apply_feedback(self.session, guess.encode(), pattern) == 0
+
+    def candidates(self):
+        n = self.lib.wordle_session_num_candidates(self.session)
+        idxs = (ctypes.c_int * n)()
+        self.lib.wordle_session_candidates(self.session, idxs, n)
+        words = []
+        for idx in idxs:
+            self.lib.wordle_dictionary_solution_word(self.dictionary, idx, self.word, len(self.word))
+            words.append(self.word.value.decode())
+        return words
+
+    def best_word(self):
+        guess = (ctypes.c_int * 1)()
+        score = (ctypes.c_double * 1)()
+        self.lib.wordle_session_rank(self.session, b'entropy', 1, guess, score)
+        return (self.guess_word(guess[0]), score[0])
+
+def solve_native(lib):
+    solver = NativeSolver(lib)
+    print(lib.wordle_dictionary_num_guesses(solver.dictionary))
+    first_guess, entrop = solver.best_word()
+    print("let's guess: ", first_guess, " which has entropy: ", entrop)
+    while True:
+        constraints_string = raw_input("Please input constraint string: (ex. t1e2a2r3s3 would mean the word contains a 't' in the correct position, 'e' and 'a' in wrong positions and does not contain 'r' or 's')\n")
+        if not solver.apply_constraints_string(constraints_string):
+            print("expected a guess and five of G/Y/B, or five letters each followed by 1, 2 or 3")
+            continue
+        constrained_words = solver.candidates()
+        if len(constrained_words) == 0:
+            print("no words found matching all constraints :(")
+            sys.exit()
+        elif len(constrained_words) == 1:
+            print("found only one choice: ", constrained_words[0])
+            sys.exit()
+
+        next_guess, entrop = solver.best_word()
+        print("let's guess: ", next_guess, "which has entropy: ", entrop, " while max entropy for this list of words is ", entropy([1.0/len(constrained_words) for i in range(len(constrained_words))], base=2))
+
 if __name__ == '__main__':
+    # --pure-python skips libwordle.so even if it's there.
+    native = None if '--pure-python' in sys.argv else load_native()
+    if native is not None:
+        solve_native(native)
+
     english_words = load_words()
 
     # count number of 5-letter words
@@ -90,13 +184,11 @@ if __name__ == '__main__':
     print("let's guess: ", first_guess, " which has entropy: ", entrop)
 
     constrained_words = five_letter_words
-    constraints = []
     while True:
         constraints_string = raw_input("Please input constraint string: (ex. t1e2a2r3s3 would mean the word contains a 't' in the correct position, 'e' and 'a' in wrong positions and does not contain 'r' or 's')\n")
         # todo: validation checking
-        new_constraints = parse_constraints_string(constraints_string)
-        constraints.extend(new_constraints)
-        constrained_words = [word for word in constrained_words if all([constraint(word) for constraint in constraints])]
+        guess, pattern = parse_constraints_string(constraints_string)
+        constrained_words = [word for word in constrained_words if feedback(guess, word) == pattern]
 
         if len(constrained_words) == 0:
             print("no words found matching all constraints :(")